@@ -1,110 +1,915 @@
-#include <iostream> 
-#include <string>   
-#include <cctype>   // Подключение библиотеки для работы с символами (например, isalnum)
-
-using namespace std; // Использование стандартного пространства имен для упрощения кода
-
-// узел стека
-struct NodeS {
-    string st; // Строка для хранения операнда или оператора
-    NodeS* next; // Указатель на следующий узел в стеке
-};
-
-// Определение структуры для стека
-struct Stak {
-    NodeS* head = nullptr; // Указатель на верхний элемент стека (начально пустой)
-
-    // Функция для добавления элемента в стек
-    void push(const string& value) {
-        // Создаем новый узел с переданным значением и указываем на текущий верхний элемент
-        NodeS* newNode = new NodeS{value, head};
-        head = newNode; // Обновляем верхний элемент стека
-    }
-
-    // Функция для извлечения элемента из стека
-    string pop() {
-        // Проверяем, не пуст ли стек
-        if (head == nullptr) {
-            throw runtime_error("Стек пуст"); // Генерируем исключение, если стек пуст
-        }
-        NodeS* temp = head; // Сохраняем текущий верхний элемент
-        string value = head->st; // Сохраняем значение верхнего элемента
-        head = head->next; // Обновляем верхний элемент стека
-        delete temp; // Удаляем старый верхний элемент
-        return value; // Возвращаем значение верхнего элемента
-    }
-
-    // Функция для проверки, пуст ли стек
-    bool isEmpty() {
-        return head == nullptr; // Возвращаем true, если стек пуст
-    }
-
-    // Функция для просмотра верхнего элемента стека
-    string top() {
-        // Проверяем, не пуст ли стек
-        if (head == nullptr) {
-            throw runtime_error("Стек пуст"); // Генерируем исключение, если стек пуст
-        }
-        return head->st; // Возвращаем значение верхнего элемента
-    }
-};
-
-// Функция для определения приоритета операторов
-int precedence(char op) {
-    // Определяем приоритет для операторов
-    if (op == '+' || op == '-') return 1; // Сложение и вычитание имеют приоритет 1
-    if (op == '*' || op == '/') return 2; // Умножение и деление имеют приоритет 2
-    return 0; // Если оператор не известен, возвращаем 0
-}
-
-// Функция для преобразования инфиксной записи в постфиксную
-string infixToPostfix(const string& infix) {
-    Stak operators; // Стек для операторов
-    string postfix; // Результирующая постфиксная запись
-
-    // Проходим по каждому символу входного инфиксного выражения
-    for (char token : infix) {
-        // Если токен - операнд (буква или цифра), добавляем его в постфиксную запись
-        if (isalnum(token)) {
-            postfix += token;
-        }
-        // Если токен - открывающая скобка, помещаем её в стек
-        else if (token == '(') {
-            operators.push(string(1, token));
-        }
-        // Если токен - закрывающая скобка
-        else if (token == ')') {
-            // Извлекаем операторы из стека до тех пор, пока не встретим открывающую скобку
-            while (!operators.isEmpty() && operators.top() != "(") {
-                postfix += operators.pop(); // Добавляем оператор в постфиксную запись
-            }
-            operators.pop(); // Удаляем открывающую скобку из стека
-        }
-        // Если токен - оператор
-        else {
-            // Извлекаем операторы из стека, пока верхний оператор имеет более высокий или равный приоритет
-            while (!operators.isEmpty() && precedence(operators.top()[0]) >= precedence(token)) {
-                postfix += operators.pop(); // Добавляем оператор в постфиксную запись
-            }
-            operators.push(string(1, token)); // Помещаем текущий оператор в стек
-        }
-    }
-
-    // Выгружаем оставшиеся операторы из стека в постфиксную запись
-    while (!operators.isEmpty()) {
-        postfix += operators.pop();
-    }
-
-    return postfix; // Возвращаем полученную постфиксную запись
-}
-
-int main() {
-    system("chcp 65001"); 
-    string infix; 
-    cout << "Введите инфиксное выражение: "; 
-    getline(cin, infix); 
-
-    string postfix = infixToPostfix(infix); 
-    cout << "Постфиксная запись: " << postfix << endl; 
-    return 0; 
-}
+#include <iostream> 
+#include <string>   
+#include <cctype>   // Подключение библиотеки для работы с символами (например, isalnum)
+#include <vector>
+#include <stdexcept>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <unordered_map>
+
+using namespace std; // Использование стандартного пространства имен для упрощения кода
+
+#ifdef COUNT_ALLOCATIONS
+// Подсчет выделений памяти для бенчмарка (сборка с -DCOUNT_ALLOCATIONS); в обычной сборке
+// глобальные operator new/delete не заменяются. Счетчик свой у каждого потока: бенчмарк
+// считает выделения своего потока, а потоки потокового режима не мешают друг другу
+static thread_local size_t allocationCount = 0;
+
+void* operator new(size_t size) {
+    ++allocationCount; // Учитываем каждое выделение памяти
+    if (void* ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+static const bool countingAllocations = true;
+#else
+static const bool countingAllocations = false;
+static size_t allocationCount = 0; // Без подсчета всегда 0
+#endif
+
+// узел стека
+struct NodeS {
+    string st; // Строка для хранения операнда или оператора
+    NodeS* next; // Указатель на следующий узел в стеке
+};
+
+// Определение структуры для стека
+struct Stak {
+    NodeS* head = nullptr; // Указатель на верхний элемент стека (начально пустой)
+
+    // Функция для добавления элемента в стек
+    void push(const string& value) {
+        // Создаем новый узел с переданным значением и указываем на текущий верхний элемент
+        NodeS* newNode = new NodeS{value, head};
+        head = newNode; // Обновляем верхний элемент стека
+    }
+
+    // Функция для извлечения элемента из стека
+    string pop() {
+        // Проверяем, не пуст ли стек
+        if (head == nullptr) {
+            throw runtime_error("Стек пуст"); // Генерируем исключение, если стек пуст
+        }
+        NodeS* temp = head; // Сохраняем текущий верхний элемент
+        string value = head->st; // Сохраняем значение верхнего элемента
+        head = head->next; // Обновляем верхний элемент стека
+        delete temp; // Удаляем старый верхний элемент
+        return value; // Возвращаем значение верхнего элемента
+    }
+
+    // Функция для проверки, пуст ли стек
+    bool isEmpty() {
+        return head == nullptr; // Возвращаем true, если стек пуст
+    }
+
+    // Функция для просмотра верхнего элемента стека
+    string top() {
+        // Проверяем, не пуст ли стек
+        if (head == nullptr) {
+            throw runtime_error("Стек пуст"); // Генерируем исключение, если стек пуст
+        }
+        return head->st; // Возвращаем значение верхнего элемента
+    }
+};
+
+// Функция для определения приоритета операторов
+int precedence(char op) {
+    // Определяем приоритет для операторов
+    if (op == '+' || op == '-') return 1; // Сложение и вычитание имеют приоритет 1
+    if (op == '*' || op == '/') return 2; // Умножение и деление имеют приоритет 2
+    return 0; // Если оператор не известен, возвращаем 0
+}
+
+// Функция для преобразования инфиксной записи в постфиксную
+string infixToPostfix(const string& infix) {
+    Stak operators; // Стек для операторов
+    string postfix; // Результирующая постфиксная запись
+
+    // Проходим по каждому символу входного инфиксного выражения
+    for (char token : infix) {
+        // Если токен - операнд (буква или цифра), добавляем его в постфиксную запись
+        if (isalnum(token)) {
+            postfix += token;
+        }
+        // Если токен - открывающая скобка, помещаем её в стек
+        else if (token == '(') {
+            operators.push(string(1, token));
+        }
+        // Если токен - закрывающая скобка
+        else if (token == ')') {
+            // Извлекаем операторы из стека до тех пор, пока не встретим открывающую скобку
+            while (!operators.isEmpty() && operators.top() != "(") {
+                postfix += operators.pop(); // Добавляем оператор в постфиксную запись
+            }
+            operators.pop(); // Удаляем открывающую скобку из стека
+        }
+        // Если токен - оператор
+        else {
+            // Извлекаем операторы из стека, пока верхний оператор имеет более высокий или равный приоритет
+            while (!operators.isEmpty() && precedence(operators.top()[0]) >= precedence(token)) {
+                postfix += operators.pop(); // Добавляем оператор в постфиксную запись
+            }
+            operators.push(string(1, token)); // Помещаем текущий оператор в стек
+        }
+    }
+
+    // Выгружаем оставшиеся операторы из стека в постфиксную запись
+    while (!operators.isEmpty()) {
+        postfix += operators.pop();
+    }
+
+    return postfix; // Возвращаем полученную постфиксную запись
+}
+
+// Тип лексемы
+enum TokenType : uint8_t {
+    TOKEN_NUMBER,   // Число (несколько цифр, возможно с дробной частью)
+    TOKEN_IDENT,    // Идентификатор (переменная)
+    TOKEN_OPERATOR, // Оператор + - * /
+    TOKEN_LPAREN,   // Открывающая скобка
+    TOKEN_RPAREN    // Закрывающая скобка
+};
+
+// Компактная лексема: хранит не копию текста, а его положение в исходной строке
+struct Token {
+    uint32_t start;  // Смещение лексемы в исходной строке
+    uint32_t length; // Длина лексемы
+    uint8_t type;    // Тип лексемы (TokenType)
+    char op;         // Символ оператора или скобки
+};
+
+// Стек на непрерывном массиве: память выделяется один раз и переиспользуется между вызовами
+template <typename T>
+struct ArrayStack {
+    vector<T> data; // Элементы стека (вершина - последний элемент)
+
+    // Функция для добавления элемента в стек
+    void push(const T& value) {
+        data.push_back(value);
+    }
+
+    // Функция для извлечения элемента из стека
+    T pop() {
+        if (data.empty()) {
+            throw runtime_error("Стек пуст"); // Генерируем исключение, если стек пуст
+        }
+        T value = data.back();
+        data.pop_back();
+        return value;
+    }
+
+    // Функция для проверки, пуст ли стек
+    bool isEmpty() const {
+        return data.empty();
+    }
+
+    // Функция для просмотра верхнего элемента стека
+    const T& top() const {
+        if (data.empty()) {
+            throw runtime_error("Стек пуст"); // Генерируем исключение, если стек пуст
+        }
+        return data.back();
+    }
+
+    // Очистка стека без освобождения памяти
+    void clear() {
+        data.clear();
+    }
+};
+
+// Преобразователь инфиксной записи в постфиксную на лексемах.
+// Все буферы принадлежат объекту и переиспользуются, поэтому после прогрева вызовы не выделяют память.
+struct PostfixConverter {
+    vector<Token> tokens;        // Лексемы последнего выражения
+    ArrayStack<Token> operators; // Стек операторов
+
+    // Разбиение строки на лексемы: числа, идентификаторы, операторы и скобки; пробелы пропускаются
+    void tokenize(string_view infix) {
+        tokens.clear();
+        size_t i = 0;
+        size_t n = infix.size();
+        while (i < n) {
+            unsigned char c = infix[i];
+            if (isspace(c)) {
+                ++i; // Пробельные символы разделяют лексемы
+                continue;
+            }
+            size_t start = i;
+            if (isdigit(c) || (c == '.' && i + 1 < n && isdigit((unsigned char)infix[i + 1]))) {
+                // Число: цифры и не более одной десятичной точки
+                bool hasDot = false;
+                while (i < n && (isdigit((unsigned char)infix[i]) || (infix[i] == '.' && !hasDot))) {
+                    hasDot = hasDot || infix[i] == '.';
+                    ++i;
+                }
+                tokens.push_back(Token{(uint32_t)start, (uint32_t)(i - start), TOKEN_NUMBER, 0});
+            } else if (isalpha(c) || c == '_') {
+                // Идентификатор: буква или '_', затем буквы, цифры и '_'
+                while (i < n && (isalnum((unsigned char)infix[i]) || infix[i] == '_')) {
+                    ++i;
+                }
+                tokens.push_back(Token{(uint32_t)start, (uint32_t)(i - start), TOKEN_IDENT, 0});
+            } else if (c == '(') {
+                tokens.push_back(Token{(uint32_t)start, 1, TOKEN_LPAREN, '('});
+                ++i;
+            } else if (c == ')') {
+                tokens.push_back(Token{(uint32_t)start, 1, TOKEN_RPAREN, ')'});
+                ++i;
+            } else if (precedence(c) > 0) {
+                tokens.push_back(Token{(uint32_t)start, 1, TOKEN_OPERATOR, (char)c});
+                ++i;
+            } else {
+                throw runtime_error("Недопустимый символ в выражении: " + string(1, (char)c));
+            }
+        }
+    }
+
+    // Преобразование в постфиксную запись; результат записывается в postfix (его буфер переиспользуется)
+    void convert(string_view infix, vector<Token>& postfix) {
+        tokenize(infix);
+        operators.clear();
+        postfix.clear();
+
+        for (const Token& token : tokens) {
+            if (token.type == TOKEN_NUMBER || token.type == TOKEN_IDENT) {
+                postfix.push_back(token); // Операнд сразу попадает в результат
+            } else if (token.type == TOKEN_LPAREN) {
+                operators.push(token);
+            } else if (token.type == TOKEN_RPAREN) {
+                // Выгружаем операторы до открывающей скобки
+                while (!operators.isEmpty() && operators.top().type != TOKEN_LPAREN) {
+                    postfix.push_back(operators.pop());
+                }
+                if (operators.isEmpty()) {
+                    throw runtime_error("Непарная закрывающая скобка");
+                }
+                operators.pop(); // Удаляем открывающую скобку из стека
+            } else {
+                // Выгружаем операторы с более высоким или равным приоритетом
+                while (!operators.isEmpty() && precedence(operators.top().op) >= precedence(token.op)) {
+                    postfix.push_back(operators.pop());
+                }
+                operators.push(token);
+            }
+        }
+
+        // Выгружаем оставшиеся операторы
+        while (!operators.isEmpty()) {
+            Token token = operators.pop();
+            if (token.type == TOKEN_LPAREN) {
+                throw runtime_error("Непарная открывающая скобка");
+            }
+            postfix.push_back(token);
+        }
+    }
+};
+
+// Дописывание постфиксной записи из лексем в строку out (лексемы разделяются пробелами)
+void appendTokens(string& out, string_view infix, const vector<Token>& postfix) {
+    for (size_t i = 0; i < postfix.size(); ++i) {
+        if (i > 0) {
+            out += ' ';
+        }
+        out.append(infix.substr(postfix[i].start, postfix[i].length));
+    }
+}
+
+// Представление постфиксной записи из лексем в виде строки (лексемы разделяются пробелами)
+string tokensToString(const string& infix, const vector<Token>& postfix) {
+    string result;
+    appendTokens(result, infix, postfix);
+    return result;
+}
+
+// Коды инструкций байткода
+enum OpCode : uint8_t {
+    OP_CONST, // Поместить в стек константу constants[operand]
+    OP_VAR,   // Поместить в стек значение переменной variables[operand]
+    OP_ADD,   // Сложение двух верхних элементов
+    OP_SUB,   // Вычитание
+    OP_MUL,   // Умножение
+    OP_DIV    // Деление
+};
+
+// Инструкция стековой машины
+struct Instruction {
+    uint8_t op;       // Код операции (OpCode)
+    uint32_t operand; // Индекс константы или переменной
+};
+
+// Скомпилированное выражение: плоский байткод, таблица констант и имена переменных
+struct CompiledExpression {
+    vector<Instruction> code; // Байткод в постфиксном порядке
+    vector<double> constants; // Таблица констант
+    vector<string> variables; // Имена переменных в порядке первого появления
+    int maxDepth = 0;         // Максимальная глубина стека при вычислении
+
+    // Индекс переменной по имени (-1, если переменной нет в выражении)
+    int variableIndex(const string& name) const {
+        for (size_t i = 0; i < variables.size(); ++i) {
+            if (variables[i] == name) {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+};
+
+// Применение бинарной операции к двум числам
+inline double applyOperation(uint8_t op, double a, double b) {
+    switch (op) {
+        case OP_ADD: return a + b;
+        case OP_SUB: return a - b;
+        case OP_MUL: return a * b;
+        default:     return a / b;
+    }
+}
+
+// Компиляция постфиксной записи из лексем в байткод со сверткой константных подвыражений
+CompiledExpression compileExpression(const string& infix, const vector<Token>& postfix) {
+    CompiledExpression result;
+    int depth = 0; // Текущая глубина стека
+    for (const Token& token : postfix) {
+        string text = infix.substr(token.start, token.length);
+        if (token.type == TOKEN_NUMBER) {
+            result.constants.push_back(stod(text));
+            result.code.push_back(Instruction{OP_CONST, (uint32_t)(result.constants.size() - 1)});
+            result.maxDepth = max(result.maxDepth, ++depth);
+        } else if (token.type == TOKEN_IDENT) {
+            int index = result.variableIndex(text);
+            if (index < 0) {
+                result.variables.push_back(text);
+                index = (int)result.variables.size() - 1;
+            }
+            result.code.push_back(Instruction{OP_VAR, (uint32_t)index});
+            result.maxDepth = max(result.maxDepth, ++depth);
+        } else {
+            if (depth < 2) {
+                throw runtime_error("Не хватает операндов для оператора " + text);
+            }
+            uint8_t op = token.op == '+' ? OP_ADD : token.op == '-' ? OP_SUB : token.op == '*' ? OP_MUL : OP_DIV;
+            size_t n = result.code.size();
+            // Константа всегда является целым подвыражением, поэтому если два последних
+            // инструкции - константы, то это и есть оба операнда: сворачиваем их
+            if (n >= 2 && result.code[n - 1].op == OP_CONST && result.code[n - 2].op == OP_CONST) {
+                double b = result.constants[result.code[n - 1].operand];
+                double& a = result.constants[result.code[n - 2].operand];
+                a = applyOperation(op, a, b);
+                result.constants.pop_back(); // Константа b была добавлена последней
+                result.code.pop_back();
+            } else {
+                result.code.push_back(Instruction{op, 0});
+            }
+            --depth;
+        }
+    }
+    if (depth != 1) {
+        throw runtime_error("Некорректное выражение");
+    }
+    return result;
+}
+
+// Вычисление выражения для одной строки значений (values[i] - значение переменной i)
+double evaluateRow(const CompiledExpression& expr, const double* values, ArrayStack<double>& stack) {
+    stack.clear();
+    for (const Instruction& ins : expr.code) {
+        if (ins.op == OP_CONST) {
+            stack.push(expr.constants[ins.operand]);
+        } else if (ins.op == OP_VAR) {
+            stack.push(values[ins.operand]);
+        } else {
+            double b = stack.pop();
+            double a = stack.pop();
+            stack.push(applyOperation(ins.op, a, b));
+        }
+    }
+    return stack.pop();
+}
+
+// Поколоночный вычислитель: каждая инструкция применяется сразу к блоку строк,
+// поэтому внутренние циклы простые и векторизуются компилятором
+struct ColumnEvaluator {
+    static constexpr size_t BLOCK = 512; // Количество строк в блоке
+    vector<double> scratch;          // Стек блоков (maxDepth * BLOCK значений)
+
+    // columns[i] - столбец значений переменной i, out - столбец результатов
+    void evaluate(const CompiledExpression& expr, const double* const* columns, size_t rows, double* out) {
+        scratch.resize((size_t)expr.maxDepth * BLOCK);
+        for (size_t base = 0; base < rows; base += BLOCK) {
+            size_t count = min(BLOCK, rows - base);
+            int depth = 0;
+            for (const Instruction& ins : expr.code) {
+                if (ins.op == OP_CONST) {
+                    double* __restrict dst = &scratch[depth++ * BLOCK];
+                    double value = expr.constants[ins.operand];
+                    for (size_t k = 0; k < count; ++k) dst[k] = value;
+                } else if (ins.op == OP_VAR) {
+                    double* __restrict dst = &scratch[depth++ * BLOCK];
+                    const double* __restrict src = columns[ins.operand] + base;
+                    for (size_t k = 0; k < count; ++k) dst[k] = src[k];
+                } else {
+                    --depth;
+                    double* __restrict a = &scratch[(depth - 1) * BLOCK];
+                    const double* __restrict b = &scratch[depth * BLOCK];
+                    switch (ins.op) {
+                        case OP_ADD: for (size_t k = 0; k < count; ++k) a[k] += b[k]; break;
+                        case OP_SUB: for (size_t k = 0; k < count; ++k) a[k] -= b[k]; break;
+                        case OP_MUL: for (size_t k = 0; k < count; ++k) a[k] *= b[k]; break;
+                        default:     for (size_t k = 0; k < count; ++k) a[k] /= b[k]; break;
+                    }
+                }
+            }
+            const double* __restrict result = &scratch[0];
+            for (size_t k = 0; k < count; ++k) out[base + k] = result[k];
+        }
+    }
+};
+
+// Закэшированный результат компиляции выражения
+struct CachedExpression {
+    string text;                // Нормализованный текст выражения (ключ кэша)
+    vector<Token> postfix;      // Постфиксная запись (смещения относятся к text)
+    CompiledExpression program; // Байткод
+    size_t bytes = 0;           // Оценка занимаемой памяти
+};
+
+// Кэш скомпилированных выражений с вытеснением давно не использованных (LRU)
+// и ограничением на суммарный объем памяти
+struct ExpressionCache {
+    list<CachedExpression> entries;                                    // Записи, от недавних к давним
+    unordered_map<string_view, list<CachedExpression>::iterator> index; // Ключ указывает на text записи
+    size_t memoryLimit;     // Ограничение памяти в байтах
+    size_t memoryUsed = 0;  // Текущая оценка занимаемой памяти
+    size_t hits = 0;        // Количество попаданий
+    size_t misses = 0;      // Количество промахов
+    size_t evictions = 0;   // Количество вытесненных записей
+    string normalized;      // Буфер нормализации ключа (переиспользуется)
+    PostfixConverter converter;
+
+    ExpressionCache(size_t limitBytes) : memoryLimit(limitBytes) {}
+
+    // Нормализация: пробелы по краям отбрасываются, внутренние серии пробелов сжимаются в один
+    void normalize(string_view infix) {
+        normalized.clear();
+        bool pendingSpace = false;
+        for (char c : infix) {
+            if (isspace((unsigned char)c)) {
+                pendingSpace = !normalized.empty();
+                continue;
+            }
+            if (pendingSpace) {
+                normalized += ' ';
+                pendingSpace = false;
+            }
+            normalized += c;
+        }
+    }
+
+    // Оценка памяти, занимаемой записью вместе с узлами списка и хеш-таблицы
+    static size_t estimateBytes(const CachedExpression& entry) {
+        size_t bytes = sizeof(CachedExpression) + 64 + entry.text.capacity()
+                     + entry.postfix.capacity() * sizeof(Token)
+                     + entry.program.code.capacity() * sizeof(Instruction)
+                     + entry.program.constants.capacity() * sizeof(double);
+        for (const string& name : entry.program.variables) {
+            bytes += sizeof(string) + name.capacity();
+        }
+        return bytes;
+    }
+
+    // Получение скомпилированного выражения; ссылка действительна до следующего вызова get
+    const CachedExpression& get(string_view infix) {
+        normalize(infix);
+        auto found = index.find(string_view(normalized));
+        if (found != index.end()) {
+            ++hits;
+            entries.splice(entries.begin(), entries, found->second); // Запись становится самой свежей
+            return entries.front();
+        }
+
+        ++misses;
+        CachedExpression entry;
+        entry.text = normalized;
+        converter.convert(entry.text, entry.postfix); // Исключение оставляет кэш неизменным
+        entry.program = compileExpression(entry.text, entry.postfix);
+        entry.postfix.shrink_to_fit();
+        entry.bytes = estimateBytes(entry);
+
+        entries.push_front(move(entry));
+        index.emplace(string_view(entries.front().text), entries.begin());
+        memoryUsed += entries.front().bytes;
+
+        // Вытесняем самые давние записи, пока не уложимся в ограничение (новая запись остается)
+        while (memoryUsed > memoryLimit && entries.size() > 1) {
+            CachedExpression& oldest = entries.back();
+            index.erase(string_view(oldest.text));
+            memoryUsed -= oldest.bytes;
+            entries.pop_back();
+            ++evictions;
+        }
+        return entries.front();
+    }
+};
+
+// Порция входного файла для потоковой обработки
+struct StreamBatch {
+    string input;      // Целые строки входного файла
+    string output;     // Постфиксные записи этих строк
+    bool ready = false; // Порция обработана рабочим потоком
+};
+
+// Потоковое преобразование файла: чтение крупными блоками, обработка строк пулом потоков
+// (у каждого свой PostfixConverter), вывод в исходном порядке. В памяти одновременно
+// находится не более slotCount порций, поэтому файл целиком никогда не загружается.
+struct StreamConverter {
+    static const size_t CHUNK = 4 << 20; // Размер блока чтения (4 МБ)
+
+    size_t slotCount;                 // Количество порций в обработке одновременно
+    vector<StreamBatch> slots;        // Кольцо порций
+    deque<size_t> jobs;               // Номера порций, ожидающих обработки
+    size_t written = 0;               // Количество выведенных порций
+    bool finished = false;            // Чтение файла завершено
+    mutex lock;
+    condition_variable jobAvailable;  // Появилась порция для обработки
+    condition_variable batchReady;    // Порция обработана
+    condition_variable slotFree;      // Порция выведена, слот свободен
+
+    StreamConverter(int threads) : slotCount(threads * 2), slots(threads * 2) {}
+
+    // Обработка одной порции: каждая строка преобразуется отдельно
+    static void processBatch(StreamBatch& batch, PostfixConverter& converter, vector<Token>& postfix) {
+        batch.output.clear();
+        string_view input = batch.input;
+        size_t pos = 0;
+        while (pos < input.size()) {
+            size_t end = input.find('\n', pos);
+            if (end == string_view::npos) {
+                end = input.size();
+            }
+            string_view line = input.substr(pos, end - pos);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            try {
+                converter.convert(line, postfix);
+                appendTokens(batch.output, line, postfix);
+            } catch (const runtime_error& e) {
+                batch.output += "Ошибка: ";
+                batch.output += e.what();
+            }
+            batch.output += '\n';
+            pos = end + 1;
+        }
+    }
+
+    // Рабочий поток: забирает порции из очереди, пока чтение не завершено
+    void worker() {
+        PostfixConverter converter; // Собственные буферы потока
+        vector<Token> postfix;
+        while (true) {
+            size_t seq;
+            {
+                unique_lock<mutex> guard(lock);
+                jobAvailable.wait(guard, [&] { return !jobs.empty() || finished; });
+                if (jobs.empty()) {
+                    return;
+                }
+                seq = jobs.front();
+                jobs.pop_front();
+            }
+            StreamBatch& batch = slots[seq % slotCount];
+            processBatch(batch, converter, postfix);
+            {
+                lock_guard<mutex> guard(lock);
+                batch.ready = true;
+            }
+            batchReady.notify_all();
+        }
+    }
+
+    // Поток вывода: печатает порции строго по порядку номеров
+    void writer(FILE* out, const size_t& total) {
+        while (true) {
+            StreamBatch* batch;
+            {
+                unique_lock<mutex> guard(lock);
+                batchReady.wait(guard, [&] {
+                    return slots[written % slotCount].ready || (finished && written == total);
+                });
+                if (finished && written == total) {
+                    return;
+                }
+                batch = &slots[written % slotCount];
+            }
+            fwrite(batch->output.data(), 1, batch->output.size(), out);
+            {
+                lock_guard<mutex> guard(lock);
+                batch->ready = false;
+                ++written;
+            }
+            slotFree.notify_all();
+        }
+    }
+
+    // Преобразование файла in с выводом в out
+    void run(FILE* in, FILE* out, int threads) {
+        size_t total = 0; // Количество прочитанных порций
+        vector<thread> pool;
+        for (int i = 0; i < threads; ++i) {
+            pool.emplace_back(&StreamConverter::worker, this);
+        }
+        thread output(&StreamConverter::writer, this, out, cref(total));
+
+        string carry; // Неполная строка с конца предыдущего блока
+        vector<char> buffer(CHUNK);
+        while (true) {
+            size_t n = fread(buffer.data(), 1, buffer.size(), in);
+            bool eof = n < buffer.size();
+            size_t cut = n;
+            if (!eof) {
+                // Порция заканчивается на последнем переводе строки блока
+                while (cut > 0 && buffer[cut - 1] != '\n') {
+                    --cut;
+                }
+                if (cut == 0) {
+                    carry.append(buffer.data(), n); // Строка длиннее блока: копим ее целиком
+                    continue;
+                }
+            }
+            {
+                unique_lock<mutex> guard(lock);
+                slotFree.wait(guard, [&] { return total - written < slotCount; });
+            }
+            StreamBatch& batch = slots[total % slotCount];
+            batch.input.swap(carry);
+            batch.input.append(buffer.data(), cut);
+            carry.assign(buffer.data() + cut, n - cut);
+            bool hasData = !batch.input.empty();
+            {
+                lock_guard<mutex> guard(lock);
+                if (hasData) {
+                    jobs.push_back(total++);
+                }
+                if (eof) {
+                    finished = true;
+                }
+            }
+            jobAvailable.notify_all();
+            if (eof) {
+                break;
+            }
+        }
+        batchReady.notify_all();
+        for (thread& t : pool) {
+            t.join();
+        }
+        output.join();
+    }
+};
+
+// Генерация случайного выражения из однобуквенных операндов (понятного обоим преобразователям)
+string randomExpression(unsigned& seed, int operands) {
+    static const char ops[] = "+-*/";
+    string expr;
+    int open = 0; // Количество незакрытых скобок
+    for (int i = 0; i < operands; ++i) {
+        seed = seed * 1103515245u + 12345u; // Линейный конгруэнтный генератор
+        if (i + 1 < operands && (seed >> 16) % 4 == 0) {
+            expr += '(';
+            ++open;
+        }
+        expr += (char)('a' + (seed >> 8) % 26);
+        if (open > 0 && (seed >> 20) % 3 == 0) {
+            expr += ')';
+            --open;
+        }
+        if (i + 1 < operands) {
+            expr += ops[(seed >> 24) % 4];
+        }
+    }
+    while (open-- > 0) {
+        expr += ')';
+    }
+    return expr;
+}
+
+// Бенчмарк: сравнение infixToPostfix и PostfixConverter по скорости и числу выделений памяти
+void runBenchmark() {
+    const int expressionCount = 1000; // Количество различных выражений
+    const int rounds = 200;           // Количество проходов по набору
+    vector<string> expressions;
+    unsigned seed = 42;
+    for (int i = 0; i < expressionCount; ++i) {
+        expressions.push_back(randomExpression(seed, 8 + i % 16));
+    }
+    const double total = (double)expressionCount * rounds;
+
+    // Исходная функция на связном стеке
+    size_t checksum = 0;
+    size_t allocationsBefore = allocationCount;
+    auto begin = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const string& expr : expressions) {
+            checksum += infixToPostfix(expr).size();
+        }
+    }
+    double oldSeconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    double oldAllocations = (allocationCount - allocationsBefore) / total;
+
+    // Новый преобразователь с переиспользуемыми буферами
+    PostfixConverter converter;
+    vector<Token> postfix;
+    allocationsBefore = allocationCount;
+    begin = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const string& expr : expressions) {
+            converter.convert(expr, postfix);
+            checksum += postfix.size();
+        }
+    }
+    double newSeconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    double newAllocations = (allocationCount - allocationsBefore) / total;
+
+    cout << "Выражений: " << (size_t)total << " (контрольная сумма " << checksum << ")" << endl;
+    cout << "infixToPostfix:   " << (size_t)(total / oldSeconds) << " выражений/с";
+    if (countingAllocations) {
+        cout << ", " << oldAllocations << " выделений памяти на выражение";
+    }
+    cout << endl << "PostfixConverter: " << (size_t)(total / newSeconds) << " выражений/с";
+    if (countingAllocations) {
+        cout << ", " << newAllocations << " выделений памяти на выражение";
+    }
+    cout << endl;
+    if (!countingAllocations) {
+        cout << "(число выделений памяти считается в сборке с -DCOUNT_ALLOCATIONS)" << endl;
+    }
+}
+
+// Бенчмарк: поколоночное вычисление против построчного
+void runEvalBenchmark() {
+    const string infix = "(a + b) * (c - d) / (e + 2 * 3.5) - (a * 4 - (1 + 1)) * f";
+    PostfixConverter converter;
+    vector<Token> postfix;
+    converter.convert(infix, postfix);
+    CompiledExpression expr = compileExpression(infix, postfix);
+
+    const size_t rows = 4096; // Строк за один вызов
+    const int rounds = 2000;  // Количество вызовов
+    size_t varCount = expr.variables.size();
+
+    // Столбцы значений (структура массивов) и те же данные построчно (массив структур)
+    vector<vector<double>> columns(varCount, vector<double>(rows));
+    vector<double> rowMajor(rows * varCount);
+    unsigned seed = 7;
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t v = 0; v < varCount; ++v) {
+            seed = seed * 1103515245u + 12345u;
+            double value = 1.0 + (seed >> 16) % 1000 / 10.0;
+            columns[v][r] = value;
+            rowMajor[r * varCount + v] = value;
+        }
+    }
+    vector<const double*> columnPtrs;
+    for (auto& column : columns) {
+        columnPtrs.push_back(column.data());
+    }
+    vector<double> out(rows);
+
+    // Построчное вычисление
+    ArrayStack<double> stack;
+    double checksum = 0;
+    auto begin = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        for (size_t r = 0; r < rows; ++r) {
+            out[r] = evaluateRow(expr, &rowMajor[r * varCount], stack);
+        }
+        checksum += out[i % rows];
+    }
+    double rowSeconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    // Поколоночное вычисление
+    ColumnEvaluator evaluator;
+    begin = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        evaluator.evaluate(expr, columnPtrs.data(), rows, out.data());
+        checksum -= out[i % rows];
+    }
+    double columnSeconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    const double total = (double)rows * rounds;
+    cout << "Инструкций после свертки констант: " << expr.code.size()
+         << " (контрольная разность " << checksum << ")" << endl;
+    cout << "Построчно:    " << (size_t)(total / rowSeconds) << " строк/с" << endl;
+    cout << "Поколоночно:  " << (size_t)(total / columnSeconds) << " строк/с" << endl;
+}
+
+// Бенчмарк: попадание в кэш против повторного преобразования и компиляции
+void runCacheBenchmark() {
+    const int formulaCount = 2000; // Количество различных формул
+    const int lookups = 1000000;   // Количество запросов
+    vector<string> formulas;
+    unsigned seed = 11;
+    for (int i = 0; i < formulaCount; ++i) {
+        formulas.push_back(randomExpression(seed, 8 + i % 16));
+    }
+    vector<int> order(lookups);
+    for (int& i : order) {
+        seed = seed * 1103515245u + 12345u;
+        i = (seed >> 8) % formulaCount;
+    }
+
+    // Преобразование и компиляция при каждом запросе
+    PostfixConverter converter;
+    vector<Token> postfix;
+    size_t checksum = 0;
+    auto begin = chrono::steady_clock::now();
+    for (int i : order) {
+        converter.convert(formulas[i], postfix);
+        checksum += compileExpression(formulas[i], postfix).code.size();
+    }
+    double compileSeconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    // Запросы через кэш (объем достаточен для всех формул)
+    ExpressionCache cache(16 << 20);
+    begin = chrono::steady_clock::now();
+    for (int i : order) {
+        checksum -= cache.get(formulas[i]).program.code.size();
+    }
+    double cacheSeconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    cout << "Кэш: попаданий " << cache.hits << ", промахов " << cache.misses
+         << ", вытеснений " << cache.evictions << ", памяти " << cache.memoryUsed
+         << " байт (контрольная разность " << checksum << ")" << endl;
+    cout << "Без кэша: " << (size_t)(lookups / compileSeconds) << " выражений/с" << endl;
+    cout << "С кэшем:  " << (size_t)(lookups / cacheSeconds) << " выражений/с" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2 && string(argv[1]) == "--stream") {
+        // Потоковый режим: --stream <файл> [число потоков]
+        FILE* in = fopen(argv[2], "rb");
+        if (in == nullptr) {
+            cerr << "Не удалось открыть файл: " << argv[2] << endl;
+            return 1;
+        }
+        int threads = argc > 3 ? atoi(argv[3]) : (int)thread::hardware_concurrency();
+        StreamConverter converter(max(threads, 1));
+        converter.run(in, stdout, max(threads, 1));
+        fclose(in);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runBenchmark(); // Режим замера производительности
+        runEvalBenchmark();
+        runCacheBenchmark();
+        return 0;
+    }
+
+    system("chcp 65001"); 
+    string infix; 
+    cout << "Введите инфиксное выражение: "; 
+    getline(cin, infix); 
+
+    try {
+        string postfix = infixToPostfix(infix); 
+        cout << "Постфиксная запись: " << postfix << endl; 
+    } catch (const runtime_error& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+    }
+
+    try {
+        PostfixConverter converter;
+        vector<Token> tokens;
+        converter.convert(infix, tokens);
+        cout << "Постфиксная запись (лексемы): " << tokensToString(infix, tokens) << endl;
+
+        // Выражение без переменных полностью сворачивается при компиляции
+        CompiledExpression expr = compileExpression(infix, tokens);
+        if (expr.variables.empty()) {
+            cout << "Значение: " << expr.constants[expr.code[0].operand] << endl;
+        }
+    } catch (const runtime_error& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+        return 1;
+    }
+    return 0; 
+}
@@ -1,150 +1,2068 @@
-#include <iostream>
-#include <fstream>
-#include <string>
-
-using namespace std; // Используем стандартное пространство имен
-
-// Структура для узла в хеш-таблице
-struct Node {
-    string data;     // Данные, хранящиеся в узле (строка)
-    Node* next;      // Указатель на следующий узел (для реализации связного списка)
-};
-
-// Структура для хеш-таблицы
-struct Set {
-    Node** table;    // Массив указателей на узлы (таблица для хеширования)
-    int size;        // Размер хеш-таблицы
-
-    // Конструктор для хеш-таблицы
-    Set(int tableSize) : size(tableSize) {
-        table = new Node*[size](); // Инициализируем массив указателей, устанавливая их в nullptr
-    }
-
-    // Хеш-функция для вычисления индекса в таблице
-    int hash(const string& value) const {
-        // Обрабатываем строку для получения целого значения
-        int hashValue = 0;
-        for (char c : value) {
-            hashValue += c; // Суммируем ASCII-коды символов
-        }
-        return hashValue % size; // Возвращаем остаток от деления на размер таблицы
-    }
-
-    // Добавление элемента в хеш-таблицу
-    void add(const string& value) {
-        // Проверяем, существует ли уже значение в множестве
-        if (contains(value)) {
-            cout << "Значение уже есть в множестве: " << value << endl; // Выводим сообщение
-            return; // Выходим из функции
-        }
-
-        int index = hash(value); // Вычисляем индекс для нового значения
-        Node* newNode = new Node{value, nullptr}; // Создаем новый узел с данным значением
-
-        // Если в таблице по вычисленному индексу нет узлов
-        if (table[index] == nullptr) {
-            table[index] = newNode; // Устанавливаем новый узел в таблицу
-        } else {
-            // Если узел уже существует, добавляем новый узел в начало связного списка
-            newNode->next = table[index]; // Устанавливаем указатель на текущий узел
-            table[index] = newNode; // Обновляем указатель на первый узел
-        }
-    }
-
-    // Удаление элемента из хеш-таблицы
-    void remove(const string& value) {
-        int index = hash(value); // Вычисляем индекс для значения
-        Node** current = &table[index]; // Указатель на указатель узла по индексу
-        while (*current != nullptr) { // Пока текущий узел не пустой
-            if ((*current)->data == value) { // Если нашли узел с нужным значением
-                Node* toDelete = *current; // Сохраняем указатель на узел для удаления
-                *current = (*current)->next; // Перенаправляем указатель на следующий узел
-                delete toDelete; // Удаляем узел
-                return; // Выходим из функции
-            }
-            current = &((*current)->next); // Переходим к следующему узлу
-        }
-    }
-
-    // Проверка наличия элемента в хеш-таблице
-    bool contains(const string& value) const {
-        int index = hash(value); // Вычисляем индекс для значения
-        Node* current = table[index]; // Получаем указатель на первый узел по индексу
-        while (current) { // Пока текущий узел не пустой
-            if (current->data == value) { // Если значение найдено
-                return true; // Возвращаем true
-            }
-            current = current->next; // Переходим к следующему узлу
-        }
-        return false; // Если значение не найдено, возвращаем false
-    }
-
-    // Деструктор для хеш-таблицы
-    ~Set() {
-        for (int i = 0; i < size; ++i) { // Проходим по всем индексам в таблице
-            Node* current = table[i]; // Получаем указатель на первый узел по индексу
-            while (current) { // Пока текущий узел не пустой
-                Node* toDelete = current; // Сохраняем узел для удаления
-                current = current->next; // Переходим к следующему узлу
-                delete toDelete; // Удаляем узел
-            }
-        }
-        delete[] table; // Освобождаем память, занятую массивом указателей
-    }
-
-    // Сохранение хеш-таблицы в файл
-    void saveToFile(const char* filename) const {
-        ofstream file(filename); // Открываем файл для записи
-        for (int i = 0; i < size; ++i) { // Проходим по всем индексам в таблице
-            Node* current = table[i]; // Получаем указатель на первый узел по индексу
-            while (current) { // Пока текущий узел не пустой
-                file << current->data << endl; // Записываем данные узла в файл
-                current = current->next; // Переходим к следующему узлу
-            }
-        }
-        file.close(); // Закрываем файл
-    }
-
-    // Загрузка хеш-таблицы из файла
-    void loadFromFile(const char* filename) {
-        ifstream file(filename); // Открываем файл для чтения
-        string value; // Переменная для хранения считываемого значения
-        while (file >> value) { // Читаем значения из файла, пока это возможно
-            add(value); // Добавляем считанное значение в хеш-таблицу
-        }
-        file.close(); // Закрываем файл
-    }
-};
-
-// Функция для выполнения команды
-void executeCommand(Set& set, const string& command, const string& value) {
-    if (command == "SETADD") { // Если команда - добавление
-        set.add(value); // Добавляем значение
-    } else if (command == "SETDEL") { // Если команда - удаление
-        set.remove(value); // Удаляем значение
-    } else if (command == "SET_AT") { // Если команда - проверка наличия
-        cout << (set.contains(value) ? "ДА" : "НЕТ") << endl; // Выводим результат проверки
-    }
-}
-
-int main(int argc, char* argv[]) {
-    // Проверяем количество аргументов командной строки
-    if (argc != 6) {
-        cerr << "Использование: " << argv[0] << " --file <путь к файлу> --query <команда> <значение>" << endl;
-        return 1; // Выход с ошибкой, если аргументов недостаточно
-    }
-
-    const char* filename = argv[2]; // Получаем путь к файлу из аргументов
-    const string command = argv[4]; // Получаем команду из аргументов
-    string value = argv[5]; // Получаем значение как строку
-
-    Set set(100); // Создаем хеш-таблицу размером 100
-    set.loadFromFile(filename); // Загружаем данные из файла в хеш-таблицу
-
-    // Выполнение команды
-    executeCommand(set, command, value); // Выполняем соответствующую команду
-
-    set.saveToFile(filename); // Сохраняем обновленную хеш-таблицу в файл
-
-    return 0;
-}
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std; // Используем стандартное пространство имен
+
+// Структура для узла в хеш-таблице
+struct Node {
+    string data;     // Данные, хранящиеся в узле (строка)
+    Node* next;      // Указатель на следующий узел (для реализации связного списка)
+};
+
+// Структура для хеш-таблицы
+struct Set {
+    Node** table;    // Массив указателей на узлы (таблица для хеширования)
+    int size;        // Размер хеш-таблицы
+
+    // Конструктор для хеш-таблицы
+    Set(int tableSize) : size(tableSize) {
+        table = new Node*[size](); // Инициализируем массив указателей, устанавливая их в nullptr
+    }
+
+    // Хеш-функция для вычисления индекса в таблице
+    int hash(const string& value) const {
+        // Обрабатываем строку для получения целого значения
+        int hashValue = 0;
+        for (char c : value) {
+            hashValue += c; // Суммируем ASCII-коды символов
+        }
+        return hashValue % size; // Возвращаем остаток от деления на размер таблицы
+    }
+
+    // Добавление элемента в хеш-таблицу
+    void add(const string& value) {
+        // Проверяем, существует ли уже значение в множестве
+        if (contains(value)) {
+            cout << "Значение уже есть в множестве: " << value << endl; // Выводим сообщение
+            return; // Выходим из функции
+        }
+
+        int index = hash(value); // Вычисляем индекс для нового значения
+        Node* newNode = new Node{value, nullptr}; // Создаем новый узел с данным значением
+
+        // Если в таблице по вычисленному индексу нет узлов
+        if (table[index] == nullptr) {
+            table[index] = newNode; // Устанавливаем новый узел в таблицу
+        } else {
+            // Если узел уже существует, добавляем новый узел в начало связного списка
+            newNode->next = table[index]; // Устанавливаем указатель на текущий узел
+            table[index] = newNode; // Обновляем указатель на первый узел
+        }
+    }
+
+    // Удаление элемента из хеш-таблицы
+    void remove(const string& value) {
+        int index = hash(value); // Вычисляем индекс для значения
+        Node** current = &table[index]; // Указатель на указатель узла по индексу
+        while (*current != nullptr) { // Пока текущий узел не пустой
+            if ((*current)->data == value) { // Если нашли узел с нужным значением
+                Node* toDelete = *current; // Сохраняем указатель на узел для удаления
+                *current = (*current)->next; // Перенаправляем указатель на следующий узел
+                delete toDelete; // Удаляем узел
+                return; // Выходим из функции
+            }
+            current = &((*current)->next); // Переходим к следующему узлу
+        }
+    }
+
+    // Проверка наличия элемента в хеш-таблице
+    bool contains(const string& value) const {
+        int index = hash(value); // Вычисляем индекс для значения
+        Node* current = table[index]; // Получаем указатель на первый узел по индексу
+        while (current) { // Пока текущий узел не пустой
+            if (current->data == value) { // Если значение найдено
+                return true; // Возвращаем true
+            }
+            current = current->next; // Переходим к следующему узлу
+        }
+        return false; // Если значение не найдено, возвращаем false
+    }
+
+    // Деструктор для хеш-таблицы
+    ~Set() {
+        for (int i = 0; i < size; ++i) { // Проходим по всем индексам в таблице
+            Node* current = table[i]; // Получаем указатель на первый узел по индексу
+            while (current) { // Пока текущий узел не пустой
+                Node* toDelete = current; // Сохраняем узел для удаления
+                current = current->next; // Переходим к следующему узлу
+                delete toDelete; // Удаляем узел
+            }
+        }
+        delete[] table; // Освобождаем память, занятую массивом указателей
+    }
+
+    // Сохранение хеш-таблицы в файл
+    void saveToFile(const char* filename) const {
+        ofstream file(filename); // Открываем файл для записи
+        for (int i = 0; i < size; ++i) { // Проходим по всем индексам в таблице
+            Node* current = table[i]; // Получаем указатель на первый узел по индексу
+            while (current) { // Пока текущий узел не пустой
+                file << current->data << endl; // Записываем данные узла в файл
+                current = current->next; // Переходим к следующему узлу
+            }
+        }
+        file.close(); // Закрываем файл
+    }
+
+    // Загрузка хеш-таблицы из файла
+    void loadFromFile(const char* filename) {
+        ifstream file(filename); // Открываем файл для чтения
+        string value; // Переменная для хранения считываемого значения
+        while (file >> value) { // Читаем значения из файла, пока это возможно
+            add(value); // Добавляем считанное значение в хеш-таблицу
+        }
+        file.close(); // Закрываем файл
+    }
+};
+
+// Сильная 64-битная хеш-функция: строка обрабатывается по 8 байт с перемешиванием умножением,
+// результат проходит финальное перемешивание splitmix64, поэтому похожие ключи и анаграммы
+// получают независимые хеши
+inline uint64_t strongHash(string_view value) {
+    const uint64_t k = 0x9E3779B97F4A7C15ull;
+    uint64_t h = value.size() * k;
+    size_t i = 0;
+    for (; i + 8 <= value.size(); i += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, value.data() + i, 8);
+        h = (h ^ chunk) * k;
+        h ^= h >> 32;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, value.data() + i, value.size() - i);
+    h = (h ^ tail) * k;
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBull;
+    h ^= h >> 31;
+    return h;
+}
+
+// Хеш-таблица с открытой адресацией в стиле Swiss table.
+// Для каждого слота хранится байт метаданных: пусто, удалено или 7 младших бит хеша.
+// Поиск сравнивает сразу группу из 16 байт метаданных (SSE2 или скалярный вариант),
+// полный хеш хранится рядом со строкой, поэтому строки сравниваются только при совпадении хешей.
+// При росте новая таблица заполняется постепенно: каждая операция переносит несколько слотов.
+struct FlatSet {
+    static constexpr int8_t EMPTY = -128;      // Слот свободен
+    static constexpr int8_t DELETED = -2;      // Слот освобожден удалением
+    static constexpr size_t GROUP = 16;        // Размер группы метаданных
+    static constexpr size_t MIGRATE_STEP = 64; // Слотов старой таблицы, переносимых за одну операцию
+
+    // Одна таблица: метаданные, кэшированные хеши и строки
+    struct Table {
+        vector<int8_t> ctrl;     // Метаданные слотов
+        vector<uint64_t> hashes; // Полные хеши
+        vector<string> values;   // Строки
+        size_t capacity = 0;     // Количество слотов (степень двойки, кратна GROUP)
+        size_t used = 0;         // Занятые слоты вместе с удаленными
+
+        void init(size_t cap) {
+            capacity = cap;
+            used = 0;
+            ctrl.assign(cap, EMPTY);
+            hashes.assign(cap, 0);
+            values.assign(cap, string());
+        }
+
+        void release() {
+            vector<int8_t>().swap(ctrl);
+            vector<uint64_t>().swap(hashes);
+            vector<string>().swap(values);
+            capacity = 0;
+            used = 0;
+        }
+
+        // Маска слотов группы с данным байтом метаданных
+        uint32_t matchByte(size_t group, int8_t byte) const {
+#ifdef __SSE2__
+            __m128i g = _mm_loadu_si128((const __m128i*)&ctrl[group * GROUP]);
+            return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(byte)));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP; ++i) {
+                if (ctrl[group * GROUP + i] == byte) {
+                    mask |= 1u << i;
+                }
+            }
+            return mask;
+#endif
+        }
+
+        // Поиск слота со значением; -1, если его нет
+        long find(string_view value, uint64_t hash) const {
+            if (capacity == 0) {
+                return -1;
+            }
+            size_t groupMask = capacity / GROUP - 1;
+            size_t group = (hash >> 7) & groupMask;
+            int8_t tag = (int8_t)(hash & 0x7F);
+            for (size_t step = 1; ; ++step) {
+                uint32_t mask = matchByte(group, tag);
+                while (mask != 0) {
+                    size_t slot = group * GROUP + __builtin_ctz(mask);
+                    if (hashes[slot] == hash && values[slot] == value) {
+                        return (long)slot;
+                    }
+                    mask &= mask - 1;
+                }
+                if (matchByte(group, EMPTY) != 0 || step > groupMask) {
+                    return -1; // В группе есть пустой слот: дальше цепочка проб не продолжалась
+                }
+                group = (group + step) & groupMask; // Треугольные пробы обходят все группы
+            }
+        }
+
+        // Вставка значения, которого точно нет в таблице
+        void insert(string&& value, uint64_t hash) {
+            size_t groupMask = capacity / GROUP - 1;
+            size_t group = (hash >> 7) & groupMask;
+            for (size_t step = 1; ; ++step) {
+                uint32_t mask = matchByte(group, EMPTY) | matchByte(group, DELETED);
+                if (mask != 0) {
+                    size_t slot = group * GROUP + __builtin_ctz(mask);
+                    if (ctrl[slot] == EMPTY) {
+                        ++used;
+                    }
+                    ctrl[slot] = (int8_t)(hash & 0x7F);
+                    hashes[slot] = hash;
+                    values[slot] = move(value);
+                    return;
+                }
+                group = (group + step) & groupMask;
+            }
+        }
+
+        // Освобождение слота
+        void erase(size_t slot) {
+            ctrl[slot] = DELETED;
+            values[slot] = string(); // Освобождаем память строки
+        }
+    };
+
+    Table current;         // Таблица, в которую идут вставки
+    Table old;             // Таблица, из которой идет перенос (пуста, если роста нет)
+    size_t migrateCursor = 0; // Следующий слот старой таблицы для переноса
+    size_t count = 0;      // Количество элементов
+
+    FlatSet() {
+        current.init(GROUP);
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // Перенос очередной порции слотов старой таблицы
+    void migrate(size_t budget) {
+        while (old.capacity != 0 && budget-- > 0) {
+            if (migrateCursor == old.capacity) {
+                old.release();
+                break;
+            }
+            if (old.ctrl[migrateCursor] >= 0) {
+                current.insert(move(old.values[migrateCursor]), old.hashes[migrateCursor]);
+                old.ctrl[migrateCursor] = DELETED; // Иначе поиск найдет в слоте пустую строку после move
+            }
+            ++migrateCursor;
+        }
+    }
+
+    // Начало роста, если таблица заполнена более чем на 7/8
+    void growIfNeeded() {
+        if ((current.used + 1) * 8 <= current.capacity * 7) {
+            return;
+        }
+        migrate(SIZE_MAX); // Предыдущий перенос должен быть завершен
+        size_t capacity = current.capacity;
+        while ((count + 1) * 16 > capacity * 7) {
+            capacity *= 2; // После роста загрузка не выше 7/16
+        }
+        old = move(current);
+        current = Table();
+        current.init(capacity);
+        migrateCursor = 0;
+    }
+
+    // Проверка наличия элемента
+    bool contains(const string& value) const {
+        uint64_t hash = strongHash(value);
+        return current.find(value, hash) >= 0 || old.find(value, hash) >= 0;
+    }
+
+    // Добавление элемента; false, если он уже есть
+    bool add(const string& value) {
+        uint64_t hash = strongHash(value);
+        if (current.find(value, hash) >= 0 || old.find(value, hash) >= 0) {
+            return false;
+        }
+        growIfNeeded();
+        current.insert(string(value), hash);
+        ++count;
+        migrate(MIGRATE_STEP);
+        return true;
+    }
+
+    // Удаление элемента; false, если его не было
+    bool remove(const string& value) {
+        uint64_t hash = strongHash(value);
+        long slot = current.find(value, hash);
+        if (slot >= 0) {
+            current.erase(slot);
+        } else if ((slot = old.find(value, hash)) >= 0) {
+            old.erase(slot);
+        } else {
+            return false;
+        }
+        --count;
+        migrate(MIGRATE_STEP);
+        return true;
+    }
+};
+
+// Множество на арене интернированных строк: байты всех строк лежат в одном растущем блоке,
+// каждая строка получает 32-битный дескриптор, а таблица с открытой адресацией хранит
+// только дескрипторы. Удаленная строка остается в арене с пометкой "нет в множестве"
+// (повторное добавление не занимает памяти); когда удаленных больше половины, арена
+// пересобирается. Освобождение всего множества - освобождение нескольких массивов.
+struct ArenaSet {
+    vector<char> bytes;        // Байты строк подряд
+    vector<uint32_t> offsets;  // Строка h занимает [offsets[h], offsets[h + 1])
+    vector<uint32_t> hashes;   // Хеш строки по дескриптору
+    vector<uint8_t> present;   // 1 - строка сейчас в множестве
+    vector<uint32_t> slots;    // Таблица: дескриптор + 1 или 0 (пусто)
+    size_t count = 0;          // Количество элементов множества
+
+    ArenaSet() {
+        offsets.push_back(0);
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    string_view get(uint32_t handle) const {
+        return string_view(bytes.data() + offsets[handle], offsets[handle + 1] - offsets[handle]);
+    }
+
+    // Слот таблицы, занятый строкой, или пустой слот для нее
+    size_t probe(string_view value, uint32_t hash) const {
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            uint32_t slot = slots[i];
+            if (slot == 0 || (hashes[slot - 1] == hash && get(slot - 1) == value)) {
+                return i;
+            }
+        }
+    }
+
+    // Перестройка таблицы слотов под capacity
+    void rehash(size_t capacity) {
+        vector<uint32_t> bigger(capacity, 0);
+        size_t mask = capacity - 1;
+        for (uint32_t h = 0; h + 1 < offsets.size(); ++h) {
+            size_t i = hashes[h] & mask;
+            while (bigger[i] != 0) i = (i + 1) & mask;
+            bigger[i] = h + 1;
+        }
+        slots.swap(bigger);
+    }
+
+    bool contains(const string& value) const {
+        if (slots.empty()) {
+            return false;
+        }
+        uint32_t slot = slots[probe(value, (uint32_t)strongHash(value))];
+        return slot != 0 && present[slot - 1];
+    }
+
+    // Добавление элемента; false, если он уже есть
+    bool add(const string& value) {
+        if (offsets.size() * 2 > slots.size()) {
+            rehash(max<size_t>(16, slots.size() * 2)); // Загрузка таблицы не выше 1/2
+        }
+        uint32_t hash = (uint32_t)strongHash(value);
+        size_t i = probe(value, hash);
+        if (slots[i] != 0) {
+            uint8_t& flag = present[slots[i] - 1];
+            if (flag) {
+                return false;
+            }
+            flag = 1; // Строка уже в арене: только возвращаем ее в множество
+            ++count;
+            return true;
+        }
+        if (bytes.size() + value.size() > UINT32_MAX) {
+            throw length_error("Арена строк переполнена");
+        }
+        bytes.insert(bytes.end(), value.begin(), value.end());
+        offsets.push_back((uint32_t)bytes.size());
+        hashes.push_back(hash);
+        present.push_back(1);
+        slots[i] = (uint32_t)hashes.size();
+        ++count;
+        return true;
+    }
+
+    // Удаление элемента; false, если его не было
+    bool remove(const string& value) {
+        if (slots.empty()) {
+            return false;
+        }
+        uint32_t slot = slots[probe(value, (uint32_t)strongHash(value))];
+        if (slot == 0 || !present[slot - 1]) {
+            return false;
+        }
+        present[slot - 1] = 0;
+        --count;
+        if (count * 2 < present.size() && present.size() > 1024) {
+            compact();
+        }
+        return true;
+    }
+
+    // Пересборка арены только из строк, которые есть в множестве
+    void compact() {
+        ArenaSet fresh;
+        fresh.bytes.reserve(bytes.size() / 2);
+        for (uint32_t h = 0; h < present.size(); ++h) {
+            if (present[h]) {
+                string_view value = get(h);
+                fresh.bytes.insert(fresh.bytes.end(), value.begin(), value.end());
+                fresh.offsets.push_back((uint32_t)fresh.bytes.size());
+                fresh.hashes.push_back(hashes[h]);
+                fresh.present.push_back(1);
+            }
+        }
+        fresh.count = count;
+        size_t capacity = 16;
+        while (capacity < fresh.offsets.size() * 2) capacity *= 2;
+        fresh.rehash(capacity);
+        *this = move(fresh);
+    }
+
+    // Освобождение всего множества
+    void release() {
+        *this = ArenaSet();
+    }
+
+    size_t memoryBytes() const {
+        return bytes.capacity() + (offsets.capacity() + hashes.capacity() + slots.capacity()) * 4 + present.capacity();
+    }
+};
+
+// Эпохи для безопасного освобождения памяти при чтении без блокировок.
+// Читатель на время обхода публикует текущую глобальную эпоху в своем слоте.
+// Объект, удаленный из структуры в эпоху r, можно освободить, когда все активные
+// читатели вошли в эпоху позже r: они начали обход уже после удаления объекта.
+struct EpochManager {
+    static constexpr int MAX_THREADS = 256;          // Максимум одновременно читающих потоков
+    static constexpr uint64_t IDLE = UINT64_MAX;     // Поток сейчас не читает
+
+    struct alignas(64) Slot {
+        atomic<uint64_t> epoch{IDLE};  // Эпоха входа читателя
+        atomic<bool> used{false};      // Слот закреплен за потоком
+    };
+
+    atomic<uint64_t> globalEpoch{1}; // Глобальная эпоха
+    Slot slots[MAX_THREADS];         // Слоты потоков
+
+    // Единственный экземпляр на процесс
+    static EpochManager& instance() {
+        static EpochManager manager;
+        return manager;
+    }
+
+    // Слот текущего потока (закрепляется при первом обращении, освобождается при завершении потока)
+    int threadSlot() {
+        struct Registration {
+            int slot = -1;
+            ~Registration() {
+                if (slot >= 0) {
+                    EpochManager::instance().slots[slot].used.store(false);
+                }
+            }
+        };
+        thread_local Registration registration;
+        if (registration.slot < 0) {
+            for (int i = 0; i < MAX_THREADS; ++i) {
+                bool expected = false;
+                if (slots[i].used.compare_exchange_strong(expected, true)) {
+                    registration.slot = i;
+                    break;
+                }
+            }
+            if (registration.slot < 0) {
+                throw runtime_error("Слишком много читающих потоков");
+            }
+        }
+        return registration.slot;
+    }
+
+    // Начало чтения
+    void enter(int slot) {
+        slots[slot].epoch.store(globalEpoch.load(), memory_order_seq_cst);
+        atomic_thread_fence(memory_order_seq_cst); // Публикация эпохи до чтения указателей
+    }
+
+    // Конец чтения
+    void leave(int slot) {
+        slots[slot].epoch.store(IDLE, memory_order_release);
+    }
+
+    // Минимальная эпоха активных читателей; если все догнали глобальную эпоху, она продвигается
+    uint64_t minActiveEpoch() {
+        atomic_thread_fence(memory_order_seq_cst);
+        uint64_t global = globalEpoch.load();
+        uint64_t minimum = global;
+        for (int i = 0; i < MAX_THREADS; ++i) {
+            minimum = min(minimum, slots[i].epoch.load());
+        }
+        if (minimum == global) {
+            globalEpoch.compare_exchange_strong(global, global + 1);
+        }
+        return minimum;
+    }
+};
+
+// Потокобезопасное множество, разбитое на шарды по хешу.
+// Чтение не берет блокировок и не ждет писателей: обход цепочки из атомарных указателей
+// защищен эпохой. Писатели блокируют только свой шард; удаленные узлы и старые массивы
+// корзин после роста освобождаются, когда их уже не может видеть ни один читатель.
+struct ConcurrentSet {
+    static constexpr size_t SHARDS = 64; // Количество шардов (степень двойки)
+
+    // Узел цепочки
+    struct CNode {
+        uint64_t hash;          // Кэшированный хеш
+        string value;           // Значение
+        atomic<CNode*> next;    // Следующий узел цепочки
+    };
+
+    // Массив корзин шарда; после публикации читателям больше не меняется по размеру
+    struct BucketArray {
+        size_t mask;                 // Количество корзин - 1
+        atomic<CNode*>* buckets;     // Головы цепочек
+
+        BucketArray(size_t count) : mask(count - 1), buckets(new atomic<CNode*>[count]) {
+            for (size_t i = 0; i < count; ++i) {
+                buckets[i].store(nullptr, memory_order_relaxed);
+            }
+        }
+
+        ~BucketArray() {
+            delete[] buckets;
+        }
+
+        // Освобождение массива вместе со всеми узлами
+        void destroyWithNodes() {
+            for (size_t i = 0; i <= mask; ++i) {
+                CNode* node = buckets[i].load(memory_order_relaxed);
+                while (node != nullptr) {
+                    CNode* next = node->next.load(memory_order_relaxed);
+                    delete node;
+                    node = next;
+                }
+            }
+            delete this;
+        }
+    };
+
+    // Объект, ожидающий освобождения
+    struct Retired {
+        uint64_t epoch;      // Эпоха удаления
+        CNode* node;         // Удаленный узел (или nullptr)
+        BucketArray* table;  // Замененный массив корзин вместе с узлами (или nullptr)
+    };
+
+    struct alignas(64) Shard {
+        atomic<BucketArray*> table{new BucketArray(16)}; // Текущий массив корзин
+        atomic<BucketArray*> old{nullptr}; // Массив, из которого идет перенос (nullptr - роста нет)
+        size_t migrateCursor = 0;  // Следующая корзина старого массива для переноса
+        size_t count = 0;          // Количество элементов шарда
+        mutex writeLock;           // Блокировка писателей шарда
+        vector<Retired> retired;   // Объекты, ожидающие освобождения
+    };
+
+    static constexpr size_t MIGRATE_STEP = 8; // Корзин старого массива, переносимых за одну запись
+
+    Shard shards[SHARDS];
+
+    ~ConcurrentSet() {
+        for (Shard& shard : shards) {
+            for (Retired& r : shard.retired) {
+                reclaimOne(r);
+            }
+            shard.table.load()->destroyWithNodes();
+            if (BucketArray* old = shard.old.load()) {
+                old->destroyWithNodes();
+            }
+        }
+    }
+
+    static void reclaimOne(Retired& r) {
+        if (r.node != nullptr) {
+            delete r.node;
+        } else {
+            r.table->destroyWithNodes();
+        }
+    }
+
+    Shard& shardOf(uint64_t hash) {
+        return shards[hash >> 58]; // Старшие 6 бит хеша
+    }
+
+    // Поиск узла в массиве корзин
+    static CNode* find(BucketArray* table, const string& value, uint64_t hash) {
+        CNode* node = table->buckets[hash & table->mask].load(memory_order_acquire);
+        while (node != nullptr) {
+            if (node->hash == hash && node->value == value) {
+                return node;
+            }
+            node = node->next.load(memory_order_acquire);
+        }
+        return nullptr;
+    }
+
+    // Поиск в шарде: в текущем массиве и, пока идет перенос, в старом.
+    // Старый массив читается до поиска: перенос только копирует узлы, а удаление убирает
+    // элемент из обоих массивов, поэтому элемент есть в старом массиве, пока тот опубликован,
+    // а после снятия старого массива - в текущем
+    static bool findInShard(Shard& shard, const string& value, uint64_t hash) {
+        BucketArray* table = shard.table.load(memory_order_acquire);
+        BucketArray* old = shard.old.load(memory_order_acquire);
+        return find(table, value, hash) != nullptr || (old != nullptr && find(old, value, hash) != nullptr);
+    }
+
+    // Проверка наличия элемента без блокировок
+    bool contains(const string& value) {
+        uint64_t hash = strongHash(value);
+        EpochManager& epochs = EpochManager::instance();
+        int slot = epochs.threadSlot();
+        epochs.enter(slot);
+        bool found = findInShard(shardOf(hash), value, hash);
+        epochs.leave(slot);
+        return found;
+    }
+
+    // Передача объекта на отложенное освобождение (вызывающий держит writeLock)
+    void retire(Shard& shard, CNode* node, BucketArray* table) {
+        EpochManager& epochs = EpochManager::instance();
+        // Снятие объекта с публикации должно стать видимым раньше чтения эпохи (как в enter)
+        atomic_thread_fence(memory_order_seq_cst);
+        shard.retired.push_back(Retired{epochs.globalEpoch.load(), node, table});
+        if (shard.retired.size() >= 64) {
+            uint64_t safe = epochs.minActiveEpoch();
+            size_t kept = 0;
+            for (Retired& r : shard.retired) {
+                if (r.epoch < safe) {
+                    reclaimOne(r);
+                } else {
+                    shard.retired[kept++] = r;
+                }
+            }
+            shard.retired.resize(kept);
+        }
+    }
+
+    // Перенос очередных корзин старого массива (вызывающий держит writeLock). Узлы копируются:
+    // читатели могут еще обходить старые цепочки. Когда перенесены все корзины, старый массив
+    // с исходными узлами снимается с публикации и освобождается позже
+    void migrate(Shard& shard, size_t budget) {
+        BucketArray* old = shard.old.load(memory_order_relaxed);
+        BucketArray* table = shard.table.load(memory_order_relaxed);
+        while (old != nullptr && budget-- > 0) {
+            if (shard.migrateCursor > old->mask) {
+                shard.old.store(nullptr, memory_order_release);
+                retire(shard, nullptr, old);
+                return;
+            }
+            for (CNode* node = old->buckets[shard.migrateCursor].load(memory_order_relaxed); node != nullptr;
+                 node = node->next.load(memory_order_relaxed)) {
+                atomic<CNode*>& head = table->buckets[node->hash & table->mask];
+                head.store(new CNode{node->hash, node->value, {head.load(memory_order_relaxed)}}, memory_order_release);
+            }
+            ++shard.migrateCursor;
+        }
+    }
+
+    // Начало роста шарда: новый массив публикуется сразу, узлы переносятся порциями
+    // при следующих записях, поэтому ни одна запись не копирует весь шард
+    void grow(Shard& shard) {
+        migrate(shard, SIZE_MAX); // Предыдущий перенос должен быть завершен
+        BucketArray* current = shard.table.load(memory_order_relaxed);
+        shard.old.store(current, memory_order_relaxed);
+        shard.migrateCursor = 0;
+        shard.table.store(new BucketArray((current->mask + 1) * 2), memory_order_release); // Публикует и old
+    }
+
+    // Добавление элемента; false, если он уже есть
+    bool add(const string& value) {
+        uint64_t hash = strongHash(value);
+        Shard& shard = shardOf(hash);
+        lock_guard<mutex> guard(shard.writeLock);
+        if (findInShard(shard, value, hash)) {
+            return false;
+        }
+        if (shard.count >= shard.table.load(memory_order_relaxed)->mask + 1) {
+            grow(shard); // Загрузка не выше одного элемента на корзину
+        }
+        BucketArray* table = shard.table.load(memory_order_relaxed);
+        atomic<CNode*>& head = table->buckets[hash & table->mask];
+        head.store(new CNode{hash, value, {head.load(memory_order_relaxed)}}, memory_order_release);
+        ++shard.count;
+        migrate(shard, MIGRATE_STEP);
+        return true;
+    }
+
+    // Исключение узла со значением из массива корзин; найденный узел отдается на освобождение
+    bool unlink(Shard& shard, BucketArray* table, const string& value, uint64_t hash) {
+        atomic<CNode*>* link = &table->buckets[hash & table->mask];
+        CNode* node = link->load(memory_order_relaxed);
+        while (node != nullptr) {
+            if (node->hash == hash && node->value == value) {
+                link->store(node->next.load(memory_order_relaxed), memory_order_release);
+                retire(shard, node, nullptr);
+                return true;
+            }
+            link = &node->next;
+            node = link->load(memory_order_relaxed);
+        }
+        return false;
+    }
+
+    // Удаление элемента; false, если его не было. Во время переноса элемент убирается
+    // из обоих массивов: в старом мог остаться исходный узел уже скопированной корзины
+    bool remove(const string& value) {
+        uint64_t hash = strongHash(value);
+        Shard& shard = shardOf(hash);
+        lock_guard<mutex> guard(shard.writeLock);
+        bool found = unlink(shard, shard.table.load(memory_order_relaxed), value, hash);
+        if (BucketArray* old = shard.old.load(memory_order_relaxed)) {
+            found = unlink(shard, old, value, hash) || found;
+        }
+        if (!found) {
+            return false;
+        }
+        --shard.count;
+        migrate(shard, MIGRATE_STEP);
+        return true;
+    }
+};
+
+// Стабильная хеш-функция FNV-1a (не зависит от размера таблицы и сохраняется в файле)
+inline uint64_t stableHash(string_view value) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : value) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Запись файла целиком: сначала во временный path.tmp, затем fsync, атомарная замена
+// и fsync каталога. Любая ошибка (в том числе нехватка места или лимит размера файла)
+// удаляет временный файл до замены, поэтому прежний файл остается нетронутым.
+// what - название файла для сообщений ("снимок", "фильтр")
+void writeFileAtomic(const string& path, const vector<pair<const void*, size_t>>& parts, const string& what) {
+    string tmpPath = path + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (file == nullptr) {
+        throw runtime_error("Не удалось создать " + what + ": " + tmpPath);
+    }
+    bool ok = true;
+    for (auto& part : parts) {
+        ok = ok && fwrite(part.first, 1, part.second, file) == part.second;
+    }
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        unlink(tmpPath.c_str());
+        throw runtime_error("Ошибка записи (" + what + "): " + tmpPath);
+    }
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        throw runtime_error("Не удалось заменить " + what + ": " + path);
+    }
+    // Каталог сбрасывается, чтобы замена пережила сбой питания
+    size_t slash = path.rfind('/');
+    string dir = slash == string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd < 0 || fsync(dirFd) != 0) {
+        if (dirFd >= 0) {
+            ::close(dirFd);
+        }
+        throw runtime_error("Не удалось сбросить каталог: " + dir);
+    }
+    ::close(dirFd);
+}
+
+// Заголовок бинарного снимка множества
+struct SnapshotHeader {
+    char magic[8];        // Сигнатура "SETSNAP1"
+    uint64_t count;       // Количество элементов
+    uint64_t bucketCount; // Количество корзин (степень двойки)
+};
+
+// Бинарный снимок множества, отображаемый в память.
+// Формат: заголовок | uint64 offsets[bucketCount + 1] | записи корзин подряд.
+// Запись: uint32 старшие биты хеша, uint32 длина, байты строки.
+// Открытие не требует разбора: поиск сразу читает нужную корзину из отображения.
+struct Snapshot {
+    int fd = -1;                      // Дескриптор файла
+    const char* data = nullptr;       // Отображение файла в память
+    size_t size = 0;                  // Размер файла
+    const SnapshotHeader* header = nullptr;
+    const uint64_t* offsets = nullptr; // Смещения начала корзин относительно records
+    const char* records = nullptr;     // Область записей
+
+    // Открытие снимка; false, если файла нет
+    bool open(const string& path) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        fstat(fd, &st);
+        size = st.st_size;
+        if (size < sizeof(SnapshotHeader)) {
+            close();
+            throw runtime_error("Поврежденный снимок: " + path);
+        }
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close();
+            throw runtime_error("Не удалось отобразить снимок: " + path);
+        }
+        data = (const char*)mapped;
+        header = (const SnapshotHeader*)data;
+        if (!valid()) {
+            close();
+            throw runtime_error("Поврежденный снимок: " + path);
+        }
+        offsets = (const uint64_t*)(data + sizeof(SnapshotHeader));
+        records = (const char*)(offsets + header->bucketCount + 1);
+        return true;
+    }
+
+    // Проверка заголовка и таблицы смещений отображенного файла: число корзин - степень
+    // двойки, таблица помещается в файл (без переполнения), смещения не убывают и не выходят
+    // за область записей. Записи внутри корзины проверяются при чтении
+    bool valid() const {
+        uint64_t bucketCount = header->bucketCount;
+        size_t available = (size - sizeof(SnapshotHeader)) / sizeof(uint64_t);
+        if (memcmp(header->magic, "SETSNAP1", 8) != 0 || bucketCount == 0 ||
+            (bucketCount & (bucketCount - 1)) != 0 || bucketCount >= available) {
+            return false;
+        }
+        const uint64_t* table = (const uint64_t*)(data + sizeof(SnapshotHeader));
+        uint64_t recordsSize = size - sizeof(SnapshotHeader) - (bucketCount + 1) * sizeof(uint64_t);
+        if (table[0] != 0 || table[bucketCount] > recordsSize) {
+            return false;
+        }
+        for (uint64_t b = 0; b < bucketCount; ++b) {
+            if (table[b] > table[b + 1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Закрытие снимка
+    void close() {
+        if (data != nullptr) {
+            munmap((void*)data, size);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+        data = nullptr;
+        header = nullptr;
+        size = 0;
+    }
+
+    // Количество элементов в снимке
+    size_t count() const {
+        return header ? header->count : 0;
+    }
+
+    // Проверка наличия элемента в снимке
+    bool contains(string_view value) const {
+        if (header == nullptr) {
+            return false;
+        }
+        uint64_t h = stableHash(value);
+        uint64_t bucket = h & (header->bucketCount - 1);
+        const char* p = records + offsets[bucket];
+        const char* end = records + offsets[bucket + 1];
+        while (end - p >= 8) {
+            uint32_t tag, length;
+            memcpy(&tag, p, 4);
+            memcpy(&length, p + 4, 4);
+            if (length > (size_t)(end - p) - 8) {
+                return false; // Запись выходит за корзину: файл поврежден
+            }
+            if (tag == (uint32_t)(h >> 32) && length == value.size() && memcmp(p + 8, value.data(), length) == 0) {
+                return true;
+            }
+            p += 8 + length;
+        }
+        return false;
+    }
+
+    // Обход всех элементов снимка
+    template <typename Func>
+    void forEach(Func func) const {
+        if (header == nullptr) {
+            return;
+        }
+        const char* p = records;
+        const char* end = records + offsets[header->bucketCount];
+        while (end - p >= 8) {
+            uint32_t length;
+            memcpy(&length, p + 4, 4);
+            if (length > (size_t)(end - p) - 8) {
+                return; // Запись выходит за область записей: файл поврежден
+            }
+            func(string_view(p + 8, length));
+            p += 8 + length;
+        }
+    }
+
+    // Запись снимка из набора элементов: сначала во временный файл, затем атомарная замена
+    static void write(const string& path, const vector<string_view>& values) {
+        uint64_t bucketCount = 1;
+        while (bucketCount < values.size()) {
+            bucketCount <<= 1; // Около одного элемента на корзину
+        }
+
+        // Сортировка подсчетом по номерам корзин
+        vector<uint64_t> hashes(values.size());
+        vector<uint64_t> offsets(bucketCount + 1, 0);
+        for (size_t i = 0; i < values.size(); ++i) {
+            hashes[i] = stableHash(values[i]);
+            offsets[(hashes[i] & (bucketCount - 1)) + 1] += 8 + values[i].size();
+        }
+        for (uint64_t b = 0; b < bucketCount; ++b) {
+            offsets[b + 1] += offsets[b];
+        }
+        vector<char> records(offsets[bucketCount]);
+        vector<uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < values.size(); ++i) {
+            char* p = &records[cursor[hashes[i] & (bucketCount - 1)]];
+            uint32_t tag = (uint32_t)(hashes[i] >> 32);
+            uint32_t length = (uint32_t)values[i].size();
+            memcpy(p, &tag, 4);
+            memcpy(p + 4, &length, 4);
+            memcpy(p + 8, values[i].data(), length);
+            cursor[hashes[i] & (bucketCount - 1)] += 8 + length;
+        }
+
+        SnapshotHeader header;
+        memcpy(header.magic, "SETSNAP1", 8);
+        header.count = values.size();
+        header.bucketCount = bucketCount;
+
+        writeFileAtomic(path, {{&header, sizeof(header)},
+                               {offsets.data(), offsets.size() * sizeof(uint64_t)},
+                               {records.data(), records.size()}}, "снимок");
+    }
+};
+
+// Заголовок файла Bloom-фильтра (дополнен до 64 байт, чтобы блоки были выровнены по строке кэша)
+struct BloomHeader {
+    char magic[8];          // Сигнатура "SETBLOM1"
+    uint64_t blockCount;    // Количество блоков по 512 бит
+    uint32_t hashCount;     // Количество бит на ключ (k)
+    uint32_t reserved;
+    uint64_t keyCount;      // Количество ключей в снимке, по которому построен фильтр
+    uint64_t snapshotBuckets; // Количество корзин этого снимка (для проверки соответствия)
+    double falsePositiveRate; // Заданная вероятность ложного срабатывания
+    char padding[16];
+};
+
+// Блочный Bloom-фильтр: все k бит ключа лежат в одном 64-байтовом блоке,
+// поэтому проверка затрагивает одну строку кэша. Фильтр строится по содержимому
+// снимка и отвечает только за снимок: изменения журнала проверяются раньше него.
+struct BloomFilter {
+    static constexpr size_t BLOCK_WORDS = 8; // 512 бит в блоке
+
+    int fd = -1;
+    const char* data = nullptr;
+    size_t size = 0;
+    const BloomHeader* header = nullptr;
+    const uint64_t* blocks = nullptr;
+
+    // Номер блока и позиции бит ключа
+    static size_t blockOf(uint64_t hash, uint64_t blockCount) {
+        return (size_t)(((hash >> 32) * blockCount) >> 32);
+    }
+
+    static uint32_t bitOf(uint64_t hash, uint32_t i) {
+        uint32_t h1 = (uint32_t)hash;
+        uint32_t h2 = (uint32_t)(hash >> 32) * 0x9E3779B1u | 1;
+        return (h1 + i * h2) & 511;
+    }
+
+    // Открытие фильтра; false, если файла нет или он построен не по этому снимку
+    bool open(const string& path, const Snapshot& snapshot) {
+        close();
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        fstat(fd, &st);
+        size = st.st_size;
+        if (size >= sizeof(BloomHeader)) {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = (const char*)mapped;
+                header = (const BloomHeader*)data;
+                blocks = (const uint64_t*)(data + sizeof(BloomHeader));
+                if (memcmp(header->magic, "SETBLOM1", 8) == 0 &&
+                    size == sizeof(BloomHeader) + header->blockCount * BLOCK_WORDS * 8 &&
+                    header->keyCount == snapshot.count() &&
+                    header->snapshotBuckets == (snapshot.header ? snapshot.header->bucketCount : 0)) {
+                    return true;
+                }
+            }
+        }
+        close();
+        return false;
+    }
+
+    void close() {
+        if (data != nullptr) {
+            munmap((void*)data, size);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+        data = nullptr;
+        header = nullptr;
+        blocks = nullptr;
+        size = 0;
+    }
+
+    bool isOpen() const {
+        return header != nullptr;
+    }
+
+    // false - ключа точно нет в снимке; true - ключ, возможно, есть
+    bool mayContain(string_view value) const {
+        uint64_t hash = strongHash(value);
+        const uint64_t* block = blocks + blockOf(hash, header->blockCount) * BLOCK_WORDS;
+        for (uint32_t i = 0; i < header->hashCount; ++i) {
+            uint32_t bit = bitOf(hash, i);
+            if ((block[bit >> 6] & (1ull << (bit & 63))) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Построение фильтра по набору ключей снимка и запись во временный файл с атомарной заменой
+    static void write(const string& path, const vector<string_view>& values,
+                      uint64_t snapshotBuckets, double falsePositiveRate) {
+        // Бит на ключ для обычного фильтра; блочному нужно примерно на 20% больше
+        double bitsPerKey = -log(falsePositiveRate) / (log(2.0) * log(2.0)) * 1.2;
+        uint32_t hashCount = (uint32_t)max(1.0, min(16.0, round(log(2.0) * bitsPerKey / 1.2)));
+        uint64_t blockCount = max<uint64_t>(1, (uint64_t)ceil(values.size() * bitsPerKey / 512));
+
+        vector<uint64_t> bits(blockCount * BLOCK_WORDS, 0);
+        for (string_view value : values) {
+            uint64_t hash = strongHash(value);
+            uint64_t* block = &bits[blockOf(hash, blockCount) * BLOCK_WORDS];
+            for (uint32_t i = 0; i < hashCount; ++i) {
+                uint32_t bit = bitOf(hash, i);
+                block[bit >> 6] |= 1ull << (bit & 63);
+            }
+        }
+
+        BloomHeader header{};
+        memcpy(header.magic, "SETBLOM1", 8);
+        header.blockCount = blockCount;
+        header.hashCount = hashCount;
+        header.keyCount = values.size();
+        header.snapshotBuckets = snapshotBuckets;
+        header.falsePositiveRate = falsePositiveRate;
+
+        writeFileAtomic(path, {{&header, sizeof(header)}, {bits.data(), bits.size() * sizeof(uint64_t)}}, "фильтр");
+    }
+};
+
+// Множество, хранящееся на диске как снимок плюс журнал изменений.
+// Файлы: <путь>.snap - снимок, <путь>.log - журнал SETADD/SETDEL,
+// <путь>.log.old - журнал, который сейчас сворачивается в новый снимок,
+// <путь>.bloom - необязательный Bloom-фильтр снимка (перестраивается при каждой свертке).
+// Запросы на чтение ничего не пишут на диск.
+struct PersistentSet {
+    string basePath;                      // Путь, переданный в --file
+    Snapshot snapshot;                    // Текущий снимок
+    unordered_map<string, bool> frozen;   // Изменения из сворачиваемого журнала (true - добавлен)
+    unordered_map<string, bool> frozenTail; // Журнал, дописанный к .log.old после прерванной свертки (новее frozen)
+    unordered_map<string, bool> changes;  // Изменения из активного журнала
+    int logFd = -1;                       // Дескриптор активного журнала (открывается при первой записи)
+    size_t logRecords = 0;                // Количество записей в активном журнале
+    size_t compactThreshold = 100000;     // Порог записей журнала для запуска свертки
+    size_t syncEvery = 0;                 // Синхронизация журнала каждые N записей (0 - не по числу)
+    long syncIntervalMs = 0;              // Синхронизация журнала каждые T мс (0 - не по времени)
+    size_t unsyncedWrites = 0;            // Записи журнала, еще не сброшенные на диск
+    chrono::steady_clock::time_point lastSync = chrono::steady_clock::now(); // Время последней синхронизации
+    double bloomFalsePositiveRate = 0;    // Вероятность ложного срабатывания фильтра (0 - фильтр не строится)
+    BloomFilter bloom;                    // Bloom-фильтр текущего снимка
+    mutable size_t bloomQueries = 0;      // Запросы, дошедшие до фильтра
+    mutable size_t bloomNegatives = 0;    // Запросы, отсеянные фильтром
+    mutable size_t bloomFalsePositives = 0; // Фильтр пропустил, а в снимке ключа нет
+    bool compacting = false;              // Идет фоновая свертка
+    thread compactor;                     // Поток свертки
+    mutable mutex lock;                   // Защищает снимок и таблицы изменений от потока свертки
+
+    ~PersistentSet() {
+        close();
+    }
+
+    string snapshotPath() const { return basePath + ".snap"; }
+    string logPath() const { return basePath + ".log"; }
+    string oldLogPath() const { return basePath + ".log.old"; }
+    string bloomPath() const { return basePath + ".bloom"; }
+
+    // Запись нового снимка: сначала фильтр, потом снимок. При сбое между ними старый журнал
+    // остается на диске и перекрывает расхождения, а несоответствующий фильтр не открывается
+    void writeSnapshot(const vector<string_view>& values) {
+        if (bloomFalsePositiveRate > 0) {
+            uint64_t bucketCount = 1;
+            while (bucketCount < values.size()) {
+                bucketCount <<= 1; // Так же, как в Snapshot::write
+            }
+            BloomFilter::write(bloomPath(), values, bucketCount, bloomFalsePositiveRate);
+        }
+        Snapshot::write(snapshotPath(), values);
+    }
+
+    // Открытие фильтра для текущего снимка; если фильтр включен, но файла нет, он строится
+    void openBloom() {
+        if (bloom.open(bloomPath(), snapshot)) {
+            double rate = bloom.header->falsePositiveRate;
+            if (bloomFalsePositiveRate == 0 && rate > 0 && rate < 1) {
+                bloomFalsePositiveRate = rate; // Сохраняем при свертках
+            }
+            return;
+        }
+        if (bloomFalsePositiveRate > 0 && snapshot.header != nullptr) {
+            vector<string_view> values;
+            values.reserve(snapshot.count());
+            snapshot.forEach([&](string_view value) { values.push_back(value); });
+            BloomFilter::write(bloomPath(), values, snapshot.header->bucketCount, bloomFalsePositiveRate);
+            bloom.open(bloomPath(), snapshot);
+        }
+    }
+
+    // Поиск в снимке с предварительной проверкой фильтром
+    bool snapshotContains(const string& value) const {
+        if (bloom.isOpen()) {
+            ++bloomQueries;
+            if (!bloom.mayContain(value)) {
+                ++bloomNegatives;
+                return false;
+            }
+            if (!snapshot.contains(value)) {
+                ++bloomFalsePositives;
+                return false;
+            }
+            return true;
+        }
+        return snapshot.contains(value);
+    }
+
+    // Чтение журнала в таблицу изменений; оборванная последняя запись (сбой при записи) отрезается
+    static size_t replayLog(const string& path, unordered_map<string, bool>& target) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return 0;
+        }
+        size_t records = 0;
+        long goodEnd = 0; // Конец последней целой записи
+        string value;
+        while (true) {
+            char op;
+            uint32_t length;
+            if (fread(&op, 1, 1, file) != 1 || fread(&length, 4, 1, file) != 1) {
+                break;
+            }
+            value.resize(length);
+            if (length > 0 && fread(&value[0], 1, length, file) != length) {
+                break;
+            }
+            target[value] = (op == '+');
+            goodEnd = ftell(file);
+            ++records;
+        }
+        fseek(file, 0, SEEK_END);
+        bool torn = ftell(file) != goodEnd;
+        fclose(file);
+        if (torn) {
+            truncate(path.c_str(), goodEnd);
+        }
+        return records;
+    }
+
+    // Открытие множества. Если снимка еще нет, содержимое импортируется из текстового файла прежнего формата
+    void open(const string& path) {
+        basePath = path;
+        if (!snapshot.open(snapshotPath())) {
+            ifstream file(basePath);
+            if (file) {
+                vector<string> lines;
+                FlatSet seen;
+                string value;
+                while (file >> value) {
+                    if (seen.add(value)) {
+                        lines.push_back(value);
+                    }
+                }
+                vector<string_view> values(lines.begin(), lines.end());
+                writeSnapshot(values);
+                snapshot.open(snapshotPath());
+            }
+        }
+        openBloom();
+        replayLog(oldLogPath(), frozen); // Свертка могла быть прервана
+        logRecords = replayLog(logPath(), changes);
+    }
+
+    // Поиск элемента без блокировки (вызывающий держит lock)
+    bool containsUnlocked(const string& value) const {
+        auto it = changes.find(value);
+        if (it != changes.end()) {
+            return it->second;
+        }
+        it = frozenTail.find(value);
+        if (it != frozenTail.end()) {
+            return it->second;
+        }
+        it = frozen.find(value);
+        if (it != frozen.end()) {
+            return it->second;
+        }
+        return snapshotContains(value);
+    }
+
+    // Проверка наличия элемента
+    bool contains(const string& value) const {
+        lock_guard<mutex> guard(lock);
+        return containsUnlocked(value);
+    }
+
+    // Дописывание записи в журнал
+    void appendLog(char op, const string& value) {
+        if (logFd < 0) {
+            logFd = ::open(logPath().c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (logFd < 0) {
+                throw runtime_error("Не удалось открыть журнал: " + logPath());
+            }
+        }
+        string record(5 + value.size(), '\0');
+        uint32_t length = (uint32_t)value.size();
+        record[0] = op;
+        memcpy(&record[1], &length, 4);
+        memcpy(&record[5], value.data(), value.size());
+        if (::write(logFd, record.data(), record.size()) != (ssize_t)record.size()) {
+            throw runtime_error("Ошибка записи в журнал: " + logPath());
+        }
+        ++logRecords;
+        ++unsyncedWrites;
+        if (syncEvery != 0 && unsyncedWrites >= syncEvery) {
+            syncLogUnlocked();
+        }
+    }
+
+    // Сброс журнала на диск (вызывающий держит lock)
+    void syncLogUnlocked() {
+        if (logFd >= 0 && unsyncedWrites > 0) {
+            fdatasync(logFd);
+        }
+        unsyncedWrites = 0;
+        lastSync = chrono::steady_clock::now();
+    }
+
+    // Сброс журнала, если истек интервал синхронизации (или принудительно)
+    void syncIfDue(bool force = false) {
+        lock_guard<mutex> guard(lock);
+        if (unsyncedWrites == 0) {
+            return;
+        }
+        bool due = force || (syncIntervalMs != 0 &&
+            chrono::steady_clock::now() - lastSync >= chrono::milliseconds(syncIntervalMs));
+        if (due) {
+            syncLogUnlocked();
+        }
+    }
+
+    // Добавление элемента; false, если он уже есть
+    bool add(const string& value) {
+        {
+            lock_guard<mutex> guard(lock);
+            if (containsUnlocked(value)) {
+                return false;
+            }
+            appendLog('+', value);
+            changes[value] = true;
+        }
+        maybeCompact();
+        return true;
+    }
+
+    // Удаление элемента; false, если его не было
+    bool remove(const string& value) {
+        {
+            lock_guard<mutex> guard(lock);
+            if (!containsUnlocked(value)) {
+                return false;
+            }
+            appendLog('-', value);
+            changes[value] = false;
+        }
+        maybeCompact();
+        return true;
+    }
+
+    // Запуск свертки, если журнал превысил порог
+    void maybeCompact() {
+        bool start;
+        {
+            lock_guard<mutex> guard(lock);
+            start = !compacting && logRecords >= compactThreshold;
+        }
+        if (start) {
+            compactAsync();
+        }
+    }
+
+    // Дописывание файла from к файлу to со сбросом на диск. При ошибке to обрезается
+    // до прежнего размера (иначе в журнале осталась бы оборванная запись) и возвращается false
+    static bool appendFile(const string& fromPath, const string& toPath) {
+        FILE* from = fopen(fromPath.c_str(), "rb");
+        if (from == nullptr) {
+            return false;
+        }
+        FILE* to = fopen(toPath.c_str(), "ab");
+        if (to == nullptr) {
+            fclose(from);
+            return false;
+        }
+        fseek(to, 0, SEEK_END);
+        long originalSize = ftell(to);
+        char buffer[1 << 16];
+        size_t n;
+        bool ok = originalSize >= 0;
+        while (ok && (n = fread(buffer, 1, sizeof(buffer), from)) > 0) {
+            ok = fwrite(buffer, 1, n, to) == n;
+        }
+        ok = ok && !ferror(from) && fflush(to) == 0 && fsync(fileno(to)) == 0;
+        fclose(from);
+        ok = (fclose(to) == 0) && ok;
+        if (!ok && originalSize >= 0) {
+            truncate(toPath.c_str(), originalSize);
+        }
+        return ok;
+    }
+
+    // Фоновая свертка журнала в новый снимок.
+    // Активный журнал переименовывается в .log.old, новые записи идут в свежий журнал,
+    // а поток свертки объединяет неизменяемые снимок и frozen в новый снимок.
+    // Под блокировкой выполняются только переименование и обмен таблиц за O(1).
+    void compactAsync() {
+        if (compactor.joinable()) {
+            compactor.join();
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            if (compacting) {
+                return;
+            }
+            if (logFd >= 0) {
+                ::close(logFd);
+                logFd = -1;
+            }
+            if (logRecords > 0) {
+                if (access(oldLogPath().c_str(), F_OK) != 0) {
+                    // Обычный случай: переименование без копирования
+                    if (rename(logPath().c_str(), oldLogPath().c_str()) != 0) {
+                        cerr << "Ошибка свертки: не удалось переименовать журнал " << logPath() << endl;
+                        return; // Журнал не тронут; свертка повторится при следующей записи
+                    }
+                } else {
+                    // Предыдущая свертка была прервана: журнал дописывается к старому
+                    // и удаляется только после успешного копирования
+                    if (!appendFile(logPath(), oldLogPath())) {
+                        cerr << "Ошибка свертки: не удалось дописать журнал к " << oldLogPath() << endl;
+                        return; // Оба журнала остаются; свертка повторится при следующей записи
+                    }
+                    unlink(logPath().c_str());
+                }
+            }
+            if (frozen.empty()) {
+                frozen.swap(changes); // Обычный случай
+            } else if (frozenTail.empty()) {
+                frozenTail.swap(changes); // Поток свертки сольет frozenTail с frozen
+            } else {
+                // frozenTail остается только после сбоя самого слияния; редкий путь
+                for (auto& change : changes) {
+                    frozenTail[change.first] = change.second;
+                }
+                changes.clear();
+            }
+            logRecords = 0;
+            unsyncedWrites = 0; // Несброшенные записи теперь в .log.old: их сбрасывает поток свертки
+            compacting = true;
+        }
+        compactor = thread(&PersistentSet::compact, this);
+    }
+
+    // Тело свертки (выполняется в отдельном потоке). Новый снимок открывается и проверяется
+    // до удаления .log.old; при любой ошибке .log.old и frozen остаются, и следующая свертка
+    // допишет к ним новый журнал и повторит попытку
+    void compact() {
+        unordered_map<string, bool> retired; // Освобождается после снятия блокировки
+        try {
+            // snapshot, frozen и frozenTail не меняются, пока compacting == true
+            int oldLogFd = ::open(oldLogPath().c_str(), O_WRONLY);
+            if (oldLogFd >= 0) {
+                fdatasync(oldLogFd); // Записи, не сброшенные до переименования
+                ::close(oldLogFd);
+            }
+            if (!frozenTail.empty()) {
+                // Слияние в копии без блокировки; под блокировкой только обмен
+                unordered_map<string, bool> merged(frozen);
+                for (auto& change : frozenTail) {
+                    merged[change.first] = change.second;
+                }
+                unordered_map<string, bool> tail;
+                lock_guard<mutex> guard(lock);
+                frozen.swap(merged);
+                frozenTail.swap(tail);
+                retired.swap(merged);
+            }
+            // Ключи frozen как string_view: проверка элементов снимка без создания строк
+            unordered_set<string_view> frozenKeys;
+            frozenKeys.reserve(frozen.size());
+            for (auto& change : frozen) {
+                frozenKeys.insert(change.first);
+            }
+            vector<string_view> values;
+            values.reserve(snapshot.count() + frozen.size());
+            snapshot.forEach([&](string_view value) {
+                if (frozenKeys.find(value) == frozenKeys.end()) {
+                    values.push_back(value);
+                }
+            });
+            for (auto& change : frozen) {
+                if (change.second) {
+                    values.push_back(change.first);
+                }
+            }
+            writeSnapshot(values);
+
+            Snapshot fresh;
+            if (!fresh.open(snapshotPath())) {
+                throw runtime_error("новый снимок не найден: " + snapshotPath());
+            }
+            if (fresh.count() != values.size()) {
+                fresh.close();
+                throw runtime_error("новый снимок не совпадает с записанным: " + snapshotPath());
+            }
+            BloomFilter freshBloom;
+            freshBloom.open(bloomPath(), fresh);
+
+            // Все изменения .log.old уже в снимке на диске
+            unlink(oldLogPath().c_str());
+            lock_guard<mutex> guard(lock);
+            bloom.close();
+            snapshot.close();
+            snapshot = fresh;
+            bloom = freshBloom;
+            retired.swap(frozen);
+            compacting = false;
+        } catch (const exception& e) {
+            cerr << "Ошибка свертки: " << e.what() << endl;
+            lock_guard<mutex> guard(lock);
+            compacting = false;
+        }
+    }
+
+    // Ожидание свертки и закрытие файлов
+    void close() {
+        if (compactor.joinable()) {
+            compactor.join();
+        }
+        if (logFd >= 0) {
+            syncLogUnlocked();
+            ::close(logFd);
+            logFd = -1;
+        }
+        bloom.close();
+        snapshot.close();
+    }
+};
+
+// Функция для выполнения команды
+void executeCommand(PersistentSet& set, const string& command, const string& value) {
+    if (command == "SETADD") { // Если команда - добавление
+        if (!set.add(value)) {
+            cout << "Значение уже есть в множестве: " << value << endl; // Выводим сообщение
+        }
+    } else if (command == "SETDEL") { // Если команда - удаление
+        set.remove(value); // Удаляем значение
+    } else if (command == "SET_AT") { // Если команда - проверка наличия
+        cout << (set.contains(value) ? "ДА" : "НЕТ") << endl; // Выводим результат проверки
+    }
+}
+
+// Гистограмма задержек в логарифмической шкале: 8 поддиапазонов на каждую степень двойки
+// наносекунд (погрешность перцентилей не больше 12.5%) при фиксированном объеме памяти
+struct LatencyHistogram {
+    static constexpr int SUB = 8; // Поддиапазонов на степень двойки
+    uint64_t counts[64 * SUB] = {}; // Счетчики корзин
+    uint64_t total = 0;             // Количество замеров
+    uint64_t maxNs = 0;             // Максимальная задержка
+
+    // Номер корзины для задержки ns
+    static int bucketOf(uint64_t ns) {
+        if (ns < SUB) {
+            return (int)ns;
+        }
+        int exp = 63 - __builtin_clzll(ns); // Номер старшего бита (>= 3)
+        int sub = (int)((ns >> (exp - 3)) & (SUB - 1));
+        return (exp - 2) * SUB + sub;
+    }
+
+    // Нижняя граница корзины в наносекундах
+    static uint64_t lowerBound(int bucket) {
+        if (bucket < SUB) {
+            return bucket;
+        }
+        int exp = bucket / SUB + 2;
+        return ((uint64_t)(SUB + bucket % SUB)) << (exp - 3);
+    }
+
+    void record(uint64_t ns) {
+        ++counts[bucketOf(ns)];
+        ++total;
+        maxNs = max(maxNs, ns);
+    }
+
+    // Перцентиль p (0..100) в наносекундах
+    uint64_t percentile(double p) const {
+        uint64_t rank = (uint64_t)(p / 100.0 * total);
+        uint64_t seen = 0;
+        for (int b = 0; b < 64 * SUB; ++b) {
+            seen += counts[b];
+            if (seen > rank) {
+                return lowerBound(b);
+            }
+        }
+        return maxNs;
+    }
+};
+
+// Резидентный режим: множество загружается один раз и обслуживает поток команд
+// "SETADD <значение>", "SETDEL <значение>", "SET_AT <значение>" по одной на строку.
+// Ответы на все команды, полученные одним чтением, отправляются одной записью.
+struct QueryServer {
+    PersistentSet& set;
+    LatencyHistogram latency[3];  // Задержки SETADD, SETDEL, SET_AT
+    uint64_t errors = 0;          // Нераспознанные команды
+    static volatile sig_atomic_t stopRequested; // Выставляется обработчиком SIGINT/SIGTERM
+
+    QueryServer(PersistentSet& s) : set(s) {}
+
+    static void onSignal(int) {
+        stopRequested = 1;
+    }
+
+    // Выполнение одной команды, ответ дописывается в out
+    void executeLine(string_view line, string& out) {
+        auto begin = chrono::steady_clock::now();
+        size_t space = line.find(' ');
+        string_view command = line.substr(0, space);
+        string value(space == string_view::npos ? string_view() : line.substr(space + 1));
+        int kind;
+        if (command == "SETADD") {
+            kind = 0;
+            out += set.add(value) ? "ДОБАВЛЕНО\n" : "УЖЕ ЕСТЬ\n";
+        } else if (command == "SETDEL") {
+            kind = 1;
+            out += set.remove(value) ? "УДАЛЕНО\n" : "НЕТ\n";
+        } else if (command == "SET_AT") {
+            kind = 2;
+            out += set.contains(value) ? "ДА\n" : "НЕТ\n";
+        } else {
+            ++errors;
+            out += "ОШИБКА: неизвестная команда\n";
+            return;
+        }
+        latency[kind].record(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count());
+    }
+
+    // Выполнение всех полных строк из in; необработанный хвост остается в in
+    void processBuffer(string& in, string& out) {
+        size_t pos = 0;
+        size_t end;
+        while ((end = in.find('\n', pos)) != string::npos) {
+            string_view line(in.data() + pos, end - pos);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (!line.empty()) {
+                executeLine(line, out);
+            }
+            pos = end + 1;
+        }
+        in.erase(0, pos);
+    }
+
+    // Запись всего буфера в дескриптор
+    static bool writeAll(int fd, const string& data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+            if (n <= 0) {
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+    // Таймаут ожидания ввода: нужен для синхронизации журнала по времени в простое
+    int pollTimeout() const {
+        return set.syncIntervalMs != 0 ? (int)set.syncIntervalMs : 1000;
+    }
+
+    // Обслуживание команд из стандартного ввода до его закрытия
+    void serveStdin() {
+        string in, out;
+        char buffer[1 << 16];
+        while (!stopRequested) {
+            pollfd p{0, POLLIN, 0};
+            if (poll(&p, 1, pollTimeout()) > 0) {
+                ssize_t n = read(0, buffer, sizeof(buffer));
+                if (n <= 0) {
+                    break;
+                }
+                in.append(buffer, n);
+                out.clear();
+                processBuffer(in, out);
+                writeAll(1, out);
+            }
+            set.syncIfDue();
+        }
+        if (!in.empty()) {
+            in += '\n'; // Последняя строка без перевода строки
+            out.clear();
+            processBuffer(in, out);
+            writeAll(1, out);
+        }
+    }
+
+    // Клиент сокета: буферы ввода и вывода, дескриптор неблокирующий
+    struct Client {
+        int fd = -1;
+        string input;     // Необработанный хвост ввода
+        string output;    // Ответы, еще не отправленные клиенту
+        size_t sent = 0;  // Отправленная часть output
+        bool eof = false; // Клиент закрыл свою сторону: после отправки ответов соединение закрывается
+    };
+
+    // Ответы накапливаются не больше этого объема; дальше ввод клиента не читается,
+    // пока он не заберет ответы (медленный клиент не раздувает память сервера)
+    static constexpr size_t MAX_PENDING_OUTPUT = 1 << 20;
+
+    static void setNonBlocking(int fd) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    // Отправка накопленных ответов без ожидания; false - соединение разорвано
+    static bool flushOutput(Client& client) {
+        while (client.sent < client.output.size()) {
+            ssize_t n = ::write(client.fd, client.output.data() + client.sent, client.output.size() - client.sent);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                return true; // Сокет заполнен: остаток уйдет по POLLOUT
+            }
+            if (n <= 0) {
+                return false;
+            }
+            client.sent += n;
+        }
+        client.output.clear();
+        client.sent = 0;
+        return true;
+    }
+
+    // Чтение доступного ввода клиента и выполнение полных строк; false - соединение разорвано
+    bool readInput(Client& client, char* buffer, size_t size) {
+        ssize_t n = read(client.fd, buffer, size);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        if (n == 0) {
+            client.eof = true;
+            if (!client.input.empty()) {
+                client.input += '\n'; // Последняя команда без перевода строки
+            }
+        } else {
+            client.input.append(buffer, n);
+        }
+        processBuffer(client.input, client.output);
+        return true;
+    }
+
+    // Обслуживание клиентов локального Unix-сокета до SIGINT/SIGTERM.
+    // Все дескрипторы неблокирующие, у каждого клиента свой буфер ответов, который
+    // отправляется по POLLOUT: медленный клиент не задерживает остальных и синхронизацию журнала
+    void serveSocket(const string& path) {
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (listener < 0 || path.size() >= sizeof(address.sun_path)) {
+            throw runtime_error("Не удалось создать сокет: " + path);
+        }
+        strcpy(address.sun_path, path.c_str());
+        unlink(path.c_str());
+        if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0) {
+            ::close(listener);
+            throw runtime_error("Не удалось открыть сокет: " + path);
+        }
+        setNonBlocking(listener);
+
+        vector<pollfd> fds;
+        vector<Client> clients; // Клиент i соответствует fds[i + 1]
+        char buffer[1 << 16];
+        while (!stopRequested) {
+            fds.assign(1, pollfd{listener, POLLIN, 0});
+            for (Client& client : clients) {
+                short events = 0;
+                if (!client.eof && client.output.size() < MAX_PENDING_OUTPUT) {
+                    events |= POLLIN;
+                }
+                if (!client.output.empty()) {
+                    events |= POLLOUT;
+                }
+                fds.push_back({client.fd, events, 0});
+            }
+            if (poll(fds.data(), fds.size(), pollTimeout()) > 0) {
+                for (size_t i = 0; i < clients.size(); ++i) {
+                    Client& client = clients[i];
+                    short revents = fds[i + 1].revents;
+                    bool alive = (revents & (POLLERR | POLLNVAL)) == 0;
+                    if (alive && (revents & (POLLIN | POLLHUP)) && !client.eof) {
+                        alive = readInput(client, buffer, sizeof(buffer));
+                    }
+                    if (alive && !client.output.empty()) {
+                        alive = flushOutput(client); // Сразу, не дожидаясь следующего poll
+                    }
+                    if (!alive || (client.eof && client.output.empty())) {
+                        ::close(client.fd);
+                        clients[i] = move(clients.back());
+                        fds[i + 1] = fds[clients.size()];
+                        clients.pop_back();
+                        --i;
+                    }
+                }
+                if (fds[0].revents & POLLIN) {
+                    int client;
+                    while ((client = accept(listener, nullptr, nullptr)) >= 0) {
+                        setNonBlocking(client);
+                        clients.emplace_back();
+                        clients.back().fd = client;
+                    }
+                }
+            }
+            set.syncIfDue();
+        }
+        for (Client& client : clients) {
+            ::close(client.fd);
+        }
+        ::close(listener);
+        unlink(path.c_str());
+    }
+
+    // Отчет о задержках по командам
+    void report() const {
+        const char* names[3] = {"SETADD", "SETDEL", "SET_AT"};
+        for (int k = 0; k < 3; ++k) {
+            if (latency[k].total == 0) {
+                continue;
+            }
+            cerr << names[k] << ": " << latency[k].total << " команд, p50 " << latency[k].percentile(50)
+                 << " нс, p90 " << latency[k].percentile(90) << " нс, p99 " << latency[k].percentile(99)
+                 << " нс, p99.9 " << latency[k].percentile(99.9) << " нс, max " << latency[k].maxNs << " нс" << endl;
+        }
+        if (errors != 0) {
+            cerr << "Нераспознанных команд: " << errors << endl;
+        }
+        if (set.bloomQueries != 0) {
+            size_t passed = set.bloomQueries - set.bloomNegatives;
+            cerr << "Bloom-фильтр: запросов " << set.bloomQueries << ", отсеяно " << set.bloomNegatives
+                 << ", пропущено " << passed << ", из них ложных срабатываний " << set.bloomFalsePositives
+                 << " (доля среди отсутствующих ключей "
+                 << (double)set.bloomFalsePositives / max<size_t>(1, set.bloomNegatives + set.bloomFalsePositives) << ")" << endl;
+        }
+    }
+};
+
+volatile sig_atomic_t QueryServer::stopRequested = 0;
+
+// Замер пропускной способности операций (миллионов операций в секунду)
+template <typename Func>
+double measureMops(size_t operations, Func func) {
+    auto begin = chrono::steady_clock::now();
+    func();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    return operations / seconds / 1e6;
+}
+
+// Проверка FlatSet посреди переноса: перенесенные слоты старой таблицы не должны находиться.
+// Пустая строка совпадает со значением, оставшимся в слоте после move
+bool checkFlatSetMigration() {
+    FlatSet flat;
+    size_t i = 0;
+    while (i < 4096) {
+        flat.add("key" + to_string(i++)); // Большая таблица: перенос идет много операций
+    }
+    flat.add("");
+    while (flat.old.capacity == 0 || flat.current.find("", strongHash("")) < 0) {
+        flat.add("key" + to_string(i++)); // Пока пустая строка не окажется в новой таблице
+    }
+    bool ok = flat.remove("") && flat.old.capacity != 0 && !flat.contains("") && !flat.remove("");
+    ok = ok && flat.add("") && flat.contains("") && flat.remove("") && !flat.contains("");
+    if (!ok) {
+        cerr << "Ошибка: FlatSet находит удаленную пустую строку во время переноса" << endl;
+    }
+    return ok;
+}
+
+// Бенчмарк add/contains/remove для FlatSet и исходного Set(100) на 10^3..maxKeys ключей
+void runBenchmark(size_t maxKeys) {
+    checkFlatSetMigration();
+    const size_t oldSetLimit = 100000; // Дальше цепочки Set(100) слишком длинные для замера
+    for (size_t n = 1000; n <= maxKeys; n *= 10) {
+        vector<string> keys(n);
+        vector<string> missing(n);
+        for (size_t i = 0; i < n; ++i) {
+            keys[i] = "key" + to_string(i);
+            missing[i] = "miss" + to_string(i);
+        }
+
+        size_t found = 0;
+        FlatSet flat;
+        double addRate = measureMops(n, [&] { for (auto& k : keys) flat.add(k); });
+        double hitRate = measureMops(n, [&] { for (auto& k : keys) found += flat.contains(k); });
+        double missRate = measureMops(n, [&] { for (auto& k : missing) found += flat.contains(k); });
+        double removeRate = measureMops(n, [&] { for (auto& k : keys) flat.remove(k); });
+        cout << "n=" << n << " FlatSet:  add " << addRate << ", contains (есть) " << hitRate
+             << ", contains (нет) " << missRate << ", remove " << removeRate << " млн оп/с" << endl;
+
+        ArenaSet arena;
+        addRate = measureMops(n, [&] { for (auto& k : keys) arena.add(k); });
+        hitRate = measureMops(n, [&] { for (auto& k : keys) found += arena.contains(k); });
+        missRate = measureMops(n, [&] { for (auto& k : missing) found += arena.contains(k); });
+        size_t arenaBytes = arena.memoryBytes();
+        removeRate = measureMops(n, [&] { for (auto& k : keys) arena.remove(k); });
+        cout << "n=" << n << " ArenaSet: add " << addRate << ", contains (есть) " << hitRate
+             << ", contains (нет) " << missRate << ", remove " << removeRate << " млн оп/с, "
+             << (double)arenaBytes / n << " байт на элемент" << endl;
+
+        if (n <= oldSetLimit) {
+            Set set(100);
+            addRate = measureMops(n, [&] { for (auto& k : keys) set.add(k); });
+            hitRate = measureMops(n, [&] { for (auto& k : keys) found += set.contains(k); });
+            missRate = measureMops(n, [&] { for (auto& k : missing) found += set.contains(k); });
+            removeRate = measureMops(n, [&] { for (auto& k : keys) set.remove(k); });
+            cout << "n=" << n << " Set(100): add " << addRate << ", contains (есть) " << hitRate
+                 << ", contains (нет) " << missRate << ", remove " << removeRate << " млн оп/с" << endl;
+        } else {
+            cout << "n=" << n << " Set(100): пропущено (слишком медленно)" << endl;
+        }
+        size_t expected = n <= oldSetLimit ? 3 * n : 2 * n; // Каждая реализация находит все n ключей
+        if (found != expected) {
+            cerr << "Ошибка: найдено " << found << " вместо " << expected << endl;
+        }
+    }
+}
+
+// Многопоточный бенчмарк: 95% SET_AT и 5% SETADD/SETDEL на 1..maxThreads потоках.
+// Для сравнения тот же поток операций выполняется над FlatSet под одной общей блокировкой.
+void runConcurrentBenchmark(int maxThreads) {
+    const size_t keyCount = 1000000;    // Ключей в множестве
+    const size_t opsPerThread = 1000000; // Операций на поток
+    vector<string> keys(keyCount * 2);  // Вторая половина ключей отсутствует в множестве
+    for (size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = "key" + to_string(i);
+    }
+    ConcurrentSet concurrent;
+    FlatSet flat;
+    mutex flatLock;
+    for (size_t i = 0; i < keyCount; ++i) {
+        concurrent.add(keys[i]);
+        flat.add(keys[i]);
+    }
+
+    // Запуск threads потоков, каждый выполняет op(ключ, операция) opsPerThread раз
+    auto run = [&](int threads, auto op) {
+        vector<thread> pool;
+        atomic<size_t> hits{0};
+        auto begin = chrono::steady_clock::now();
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t] {
+                unsigned seed = 12345u + t * 7919u;
+                size_t found = 0;
+                for (size_t i = 0; i < opsPerThread; ++i) {
+                    seed = seed * 1103515245u + 12345u;
+                    const string& key = keys[(seed >> 4) % keys.size()];
+                    unsigned kind = (seed >> 27) % 20; // 0 - SETADD, 1 - SETDEL, иначе SET_AT
+                    found += op(key, kind);
+                }
+                hits += found;
+            });
+        }
+        for (thread& t : pool) {
+            t.join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        return threads * opsPerThread / seconds / 1e6;
+    };
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        double sharded = run(threads, [&](const string& key, unsigned kind) -> size_t {
+            if (kind == 0) return concurrent.add(key);
+            if (kind == 1) return concurrent.remove(key);
+            return concurrent.contains(key);
+        });
+        double locked = run(threads, [&](const string& key, unsigned kind) -> size_t {
+            lock_guard<mutex> guard(flatLock);
+            if (kind == 0) return flat.add(key);
+            if (kind == 1) return flat.remove(key);
+            return flat.contains(key);
+        });
+        cout << "потоков " << threads << ": ConcurrentSet " << sharded
+             << " млн оп/с, FlatSet под блокировкой " << locked << " млн оп/с" << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && string(argv[1]) == "--bench-concurrent") {
+        // Многопоточный замер: --bench-concurrent [максимальное число потоков, по умолчанию 64]
+        runConcurrentBenchmark(argc > 2 ? atoi(argv[2]) : 64);
+        return 0;
+    }
+    if (argc >= 2 && string(argv[1]) == "--bench") {
+        // Режим замера: --bench [максимальное число ключей, по умолчанию 10^6]
+        runBenchmark(argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+    signal(SIGXFSZ, SIG_IGN); // Превышение лимита размера файла - ошибка записи, а не завершение
+
+    if (argc >= 4 && string(argv[1]) == "--file" && string(argv[3]) == "--serve") {
+        // Резидентный режим: --file <путь> --serve [--socket <путь>] [--sync-every N] [--sync-ms T] [--bloom-fpr P]
+        string socketPath;
+        try {
+            PersistentSet set;
+            for (int i = 4; i + 1 < argc; i += 2) {
+                string option = argv[i];
+                if (option == "--socket") {
+                    socketPath = argv[i + 1];
+                } else if (option == "--sync-every") {
+                    set.syncEvery = strtoull(argv[i + 1], nullptr, 10);
+                } else if (option == "--sync-ms") {
+                    set.syncIntervalMs = strtol(argv[i + 1], nullptr, 10);
+                } else if (option == "--bloom-fpr") {
+                    double rate = strtod(argv[i + 1], nullptr);
+                    if (!(rate > 0 && rate < 1)) { // Вне (0, 1) число бит на ключ не определено
+                        cerr << "Вероятность ложного срабатывания должна быть в интервале (0, 1): " << argv[i + 1] << endl;
+                        return 1;
+                    }
+                    set.bloomFalsePositiveRate = rate;
+                } else {
+                    cerr << "Неизвестный параметр: " << option << endl;
+                    return 1;
+                }
+            }
+            set.open(argv[2]);
+
+            QueryServer server(set);
+            signal(SIGINT, QueryServer::onSignal);
+            signal(SIGTERM, QueryServer::onSignal);
+            signal(SIGPIPE, SIG_IGN);
+            if (socketPath.empty()) {
+                server.serveStdin();
+            } else {
+                server.serveSocket(socketPath);
+            }
+            set.close(); // Сбрасывает журнал на диск
+            server.report();
+        } catch (const runtime_error& e) {
+            cerr << "Ошибка: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Проверяем количество аргументов командной строки
+    if (argc != 6) {
+        cerr << "Использование: " << argv[0] << " --file <путь к файлу> --query <команда> <значение>" << endl;
+        cerr << "       " << argv[0] << " --file <путь к файлу> --serve [--socket <путь>] [--sync-every N] [--sync-ms T] [--bloom-fpr P]" << endl;
+        return 1; // Выход с ошибкой, если аргументов недостаточно
+    }
+
+    const char* filename = argv[2]; // Получаем путь к файлу из аргументов
+    const string command = argv[4]; // Получаем команду из аргументов
+    string value = argv[5]; // Получаем значение как строку
+
+    try {
+        PersistentSet set; // Множество на диске: снимок и журнал изменений
+        set.open(filename); // Открываем снимок без разбора и читаем журнал
+
+        // Выполнение команды
+        executeCommand(set, command, value); // Выполняем соответствующую команду
+
+        set.close(); // Дожидаемся фоновой свертки, если она была запущена
+    } catch (const runtime_error& e) {
+        cerr << "Ошибка: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
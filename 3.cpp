@@ -1,145 +1,1454 @@
-#include <iostream>
-#include <string>
-
-using namespace std;
-
-// Определение структуры узла для связного списка
-struct Node {
-    string value; // Значение элемента
-    Node* next;   // Указатель на следующий узел
-};
-
-// Определение структуры для множества
-struct Set {
-    Node* head; // Указатель на голову списка
-
-    // Конструктор для инициализации множества
-    Set() : head(nullptr) {}
-
-    // Деструктор для освобождения памяти
-    ~Set() {
-        Node* current = head;
-        while (current != nullptr) {
-            Node* next = current->next;
-            delete current;
-            current = next;
-        }
-    }
-
-    // Метод для добавления элемента в множество
-    void add(const string& value) {
-        if (!contains(value)) { // Проверяем, существует ли элемент в множестве
-            Node* newNode = new Node{value, nullptr}; // Создаем новый узел
-            if (head == nullptr) { // Если список пуст
-                head = newNode; // Новый узел становится головой списка
-            } else {
-                Node* current = head;
-                while (current->next != nullptr) { // Находим последний узел
-                    current = current->next;
-                }
-                current->next = newNode; // Добавляем новый узел в конец списка
-            }
-        }
-    }
-
-    // Метод для проверки наличия элемента в множестве
-    bool contains(const string& value) const {
-        Node* current = head;
-        while (current != nullptr) {
-            if (current->value == value) {
-                return true; // Элемент найден
-            }
-            current = current->next;
-        }
-        return false; // Элемент не найден
-    }
-
-    // Метод для вывода множества
-    void print() const {
-        Node* current = head;
-        while (current != nullptr) {
-            cout << current->value << " ";
-            current = current->next;
-        }
-        cout << endl;
-    }
-
-    // Метод для пересечения множеств
-    Set intersectionWith(const Set& other) const {
-        Set result;
-        Node* current = head;
-        while (current != nullptr) {
-            if (other.contains(current->value)) {
-                result.add(current->value); // Добавляем элемент, если он есть в другом множестве
-            }
-            current = current->next;
-        }
-        return result;
-    }
-
-    // Метод для разности множеств
-    Set differenceWith(const Set& other) const {
-        Set result;
-        Node* current = head;
-        while (current != nullptr) {
-            if (!other.contains(current->value)) {
-                result.add(current->value); // Добавляем элемент, если его нет в другом множестве
-            }
-            current = current->next;
-        }
-        return result;
-    }
-
-    // Метод для объединения множеств
-    Set unionWith(const Set& other) const {
-        Set result = *this; // Начинаем с текущего множества
-        Node* current = other.head;
-        while (current != nullptr) {
-            result.add(current->value); // Добавляем элементы из другого множества
-            current = current->next;
-        }
-        return result;
-    }
-};
-
-int main() {
-    Set set1;
-    Set set2;
-
-    // Добавляем элементы в первое множество
-    set1.add("1");
-    set1.add("2");
-    set1.add("3");
-    set1.add("4");
-    set1.add("5");
-
-    // Добавляем элементы во второе множество
-    set2.add("3");
-    set2.add("4");
-    set2.add("5");
-    set2.add("6");
-    set2.add("7");
-
-    cout << "Первое множество: ";
-    set1.print();
-
-    cout << "Второе множество: ";
-    set2.print();
-
-    // Пересечение множеств
-    Set intersectionSet = set1.intersectionWith(set2);
-    cout << "Пересечение множеств: ";
-    intersectionSet.print();
-
-    // Разность множеств
-    Set differenceSet = set1.differenceWith(set2);
-    cout << "Разность множеств (set1 - set2): ";
-    differenceSet.print();
-
-    // Объединение множеств
-    Set unionSet = set1.unionWith(set2);
-    cout << "Объединение множеств: ";
-    unionSet.print();
-
-    return 0;
-}
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <malloc.h>
+#include <thread>
+#include <atomic>
+#include <string_view>
+#include <cstring>
+#include <fstream>
+#include <cstdio>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// Учет памяти кучи для бенчмарков: текущий и пиковый объем выделенной памяти
+// (счетчики атомарные, так как память выделяется и из рабочих потоков)
+static atomic<size_t> heapBytes{0};       // Занято сейчас
+static atomic<size_t> heapPeakBytes{0};   // Максимум с последнего сброса
+static atomic<size_t> heapAllocations{0}; // Количество выделений
+
+void* operator new(size_t size) {
+    void* ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        throw bad_alloc();
+    }
+    size_t bytes = malloc_usable_size(ptr);
+    size_t now = heapBytes.fetch_add(bytes, memory_order_relaxed) + bytes;
+    if (now > heapPeakBytes.load(memory_order_relaxed)) {
+        heapPeakBytes.store(now, memory_order_relaxed);
+    }
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr != nullptr) {
+        heapBytes.fetch_sub(malloc_usable_size(ptr), memory_order_relaxed);
+        free(ptr);
+    }
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+// Определение структуры узла для связного списка
+struct Node {
+    string value; // Значение элемента
+    Node* next;   // Указатель на следующий узел
+};
+
+// Определение структуры для множества
+struct Set {
+    Node* head; // Указатель на голову списка
+
+    // Конструктор для инициализации множества
+    Set() : head(nullptr) {}
+
+    // Конструктор копирования: создает собственные узлы (глубокая копия)
+    Set(const Set& other) : head(nullptr) {
+        copyFrom(other);
+    }
+
+    // Конструктор перемещения: забирает узлы другого множества без копирования
+    Set(Set&& other) noexcept : head(other.head) {
+        other.head = nullptr;
+    }
+
+    // Присваивание копированием
+    Set& operator=(const Set& other) {
+        if (this != &other) {
+            clear();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    // Присваивание перемещением
+    Set& operator=(Set&& other) noexcept {
+        if (this != &other) {
+            clear();
+            head = other.head;
+            other.head = nullptr;
+        }
+        return *this;
+    }
+
+    // Деструктор для освобождения памяти
+    ~Set() {
+        clear();
+    }
+
+    // Удаление всех узлов
+    void clear() {
+        Node* current = head;
+        while (current != nullptr) {
+            Node* next = current->next;
+            delete current;
+            current = next;
+        }
+        head = nullptr;
+    }
+
+    // Копирование узлов другого множества в пустое множество с сохранением порядка
+    void copyFrom(const Set& other) {
+        Node** tail = &head;
+        for (Node* current = other.head; current != nullptr; current = current->next) {
+            *tail = new Node{current->value, nullptr};
+            tail = &(*tail)->next;
+        }
+    }
+
+    // Метод для добавления элемента в множество
+    void add(const string& value) {
+        if (!contains(value)) { // Проверяем, существует ли элемент в множестве
+            Node* newNode = new Node{value, nullptr}; // Создаем новый узел
+            if (head == nullptr) { // Если список пуст
+                head = newNode; // Новый узел становится головой списка
+            } else {
+                Node* current = head;
+                while (current->next != nullptr) { // Находим последний узел
+                    current = current->next;
+                }
+                current->next = newNode; // Добавляем новый узел в конец списка
+            }
+        }
+    }
+
+    // Метод для проверки наличия элемента в множестве
+    bool contains(const string& value) const {
+        Node* current = head;
+        while (current != nullptr) {
+            if (current->value == value) {
+                return true; // Элемент найден
+            }
+            current = current->next;
+        }
+        return false; // Элемент не найден
+    }
+
+    // Метод для вывода множества
+    void print() const {
+        Node* current = head;
+        while (current != nullptr) {
+            cout << current->value << " ";
+            current = current->next;
+        }
+        cout << endl;
+    }
+
+    // Метод для пересечения множеств
+    Set intersectionWith(const Set& other) const {
+        Set result;
+        Node* current = head;
+        while (current != nullptr) {
+            if (other.contains(current->value)) {
+                result.add(current->value); // Добавляем элемент, если он есть в другом множестве
+            }
+            current = current->next;
+        }
+        return result;
+    }
+
+    // Метод для разности множеств
+    Set differenceWith(const Set& other) const {
+        Set result;
+        Node* current = head;
+        while (current != nullptr) {
+            if (!other.contains(current->value)) {
+                result.add(current->value); // Добавляем элемент, если его нет в другом множестве
+            }
+            current = current->next;
+        }
+        return result;
+    }
+
+    // Метод для объединения множеств
+    Set unionWith(const Set& other) const {
+        Set result = *this; // Начинаем с копии текущего множества
+        Node* current = other.head;
+        while (current != nullptr) {
+            result.add(current->value); // Добавляем элементы из другого множества
+            current = current->next;
+        }
+        return result;
+    }
+};
+
+// Отсортированный участок массива без владения памятью (часть множества для параллельной обработки)
+template <typename T>
+struct SortedRange {
+    const T* first; // Начало участка
+    const T* last;  // Конец участка
+
+    const T* begin() const { return first; }
+    const T* end() const { return last; }
+    size_t size() const { return last - first; }
+    const T& operator[](size_t i) const { return first[i]; }
+};
+
+// Галопирующий поиск: первая позиция в [from, data.size()) со значением не меньше value
+template <typename C, typename T>
+size_t gallop(const C& data, size_t from, const T& value) {
+    size_t step = 1;
+    size_t hi = from;
+    while (hi < data.size() && data[hi] < value) {
+        from = hi + 1;
+        hi += step;
+        step *= 2; // Шаг удваивается, пока не перескочим значение
+    }
+    return lower_bound(data.begin() + from, data.begin() + min(hi, data.size()), value) - data.begin();
+}
+
+// Отношение размеров, начиная с которого слияние заменяется галопирующим поиском
+const size_t GALLOP_RATIO = 32;
+
+// Пересечение отсортированных массивов слиянием или галопированием (при сильно разных размерах)
+template <typename C, typename T>
+void intersectSorted(const C& a, const C& b, vector<T>& out) {
+    if (a.size() > b.size()) {
+        intersectSorted(b, a, out); // Первым идет меньший массив
+        return;
+    }
+    if (a.size() * GALLOP_RATIO < b.size()) {
+        size_t j = 0;
+        for (const T& value : a) {
+            j = gallop(b, j, value);
+            if (j == b.size()) {
+                break;
+            }
+            if (b[j] == value) {
+                out.push_back(value);
+            }
+        }
+        return;
+    }
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            out.push_back(a[i]);
+            ++i;
+            ++j;
+        }
+    }
+}
+
+// Пересечение отсортированных массивов целых: блоки по 4 элемента сравниваются
+// "все со всеми" за 4 сравнения SSE2 (второй блок циклически сдвигается)
+template <typename C>
+void intersectSortedSimd(const C& a, const C& b, vector<int32_t>& out) {
+    if (a.size() * GALLOP_RATIO < b.size() || b.size() * GALLOP_RATIO < a.size()) {
+        intersectSorted(a, b, out); // Для сильно разных размеров выгоднее галопирование
+        return;
+    }
+    size_t i = 0, j = 0;
+#ifdef __SSE2__
+    while (i + 4 <= a.size() && j + 4 <= b.size()) {
+        __m128i va = _mm_loadu_si128((const __m128i*)&a[i]);
+        __m128i vb = _mm_loadu_si128((const __m128i*)&b[j]);
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(va, vb),
+                         _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                         _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq)); // Бит k - a[i + k] есть в блоке b
+        while (mask != 0) {
+            out.push_back(a[i + __builtin_ctz(mask)]);
+            mask &= mask - 1;
+        }
+        int32_t lastA = a[i + 3];
+        int32_t lastB = b[j + 3];
+        if (lastA <= lastB) i += 4; // Сдвигаем блок с меньшим последним элементом
+        if (lastB <= lastA) j += 4;
+    }
+#endif
+    // Хвосты обрабатываются обычным слиянием
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            out.push_back(a[i]);
+            ++i;
+            ++j;
+        }
+    }
+}
+
+// Разность отсортированных массивов (элементы a, которых нет в b)
+template <typename C, typename T>
+void differenceSorted(const C& a, const C& b, vector<T>& out) {
+    bool gallopB = a.size() * GALLOP_RATIO < b.size(); // b намного больше: ищем в нем галопированием
+    size_t j = 0;
+    for (const T& value : a) {
+        if (gallopB) {
+            j = gallop(b, j, value);
+        } else {
+            while (j < b.size() && b[j] < value) {
+                ++j;
+            }
+        }
+        if (j == b.size() || !(b[j] == value)) {
+            out.push_back(value);
+        }
+    }
+}
+
+// Объединение отсортированных массивов слиянием
+template <typename C, typename T>
+void unionSorted(const C& a, const C& b, vector<T>& out) {
+    out.reserve(a.size() + b.size());
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j]) {
+            out.push_back(a[i++]);
+        } else if (b[j] < a[i]) {
+            out.push_back(b[j++]);
+        } else {
+            out.push_back(a[i++]);
+            ++j;
+        }
+    }
+    out.insert(out.end(), a.begin() + i, a.end());
+    out.insert(out.end(), b.begin() + j, b.end());
+}
+
+// Ядро пересечения участков (для целых ключей - SIMD)
+template <typename T>
+void intersectRanges(const SortedRange<T>& a, const SortedRange<T>& b, vector<T>& out) {
+    intersectSorted(a, b, out);
+}
+
+inline void intersectRanges(const SortedRange<int32_t>& a, const SortedRange<int32_t>& b, vector<int32_t>& out) {
+    intersectSortedSimd(a, b, out);
+}
+
+// Суммарный размер входов, ниже которого операции выполняются в одном потоке
+const size_t PARALLEL_THRESHOLD = 1 << 16;
+
+// Параллельная операция над отсортированными массивами.
+// Оба массива режутся на участки по одним и тем же границам ключей (квантилям большего массива),
+// каждый участок обрабатывается своим потоком в свой буфер, затем буферы параллельно
+// переносятся в результат по заранее вычисленным смещениям. Общих блокировок нет.
+template <typename T, typename Kernel>
+void parallelSetOperation(const vector<T>& a, const vector<T>& b, vector<T>& out, int threads, Kernel kernel) {
+    if (threads <= 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    SortedRange<T> wholeA{a.data(), a.data() + a.size()};
+    SortedRange<T> wholeB{b.data(), b.data() + b.size()};
+    if (threads == 1 || a.size() + b.size() < PARALLEL_THRESHOLD) {
+        kernel(wholeA, wholeB, out); // Последовательный путь для небольших входов
+        return;
+    }
+
+    const vector<T>& larger = a.size() >= b.size() ? a : b;
+    size_t parts = threads;
+    vector<const T*> cutA(parts + 1), cutB(parts + 1);
+    cutA[0] = wholeA.first;
+    cutB[0] = wholeB.first;
+    cutA[parts] = wholeA.last;
+    cutB[parts] = wholeB.last;
+    for (size_t p = 1; p < parts; ++p) {
+        const T& splitter = larger[larger.size() * p / parts];
+        cutA[p] = lower_bound(wholeA.first, wholeA.last, splitter);
+        cutB[p] = lower_bound(wholeB.first, wholeB.last, splitter);
+    }
+
+    vector<vector<T>> partial(parts);
+    vector<thread> pool;
+    for (size_t p = 0; p < parts; ++p) {
+        pool.emplace_back([&, p] {
+            kernel(SortedRange<T>{cutA[p], cutA[p + 1]}, SortedRange<T>{cutB[p], cutB[p + 1]}, partial[p]);
+        });
+    }
+    for (thread& t : pool) {
+        t.join();
+    }
+
+    vector<size_t> offsets(parts + 1, 0);
+    for (size_t p = 0; p < parts; ++p) {
+        offsets[p + 1] = offsets[p] + partial[p].size();
+    }
+    out.resize(offsets[parts]);
+    pool.clear();
+    for (size_t p = 0; p < parts; ++p) {
+        pool.emplace_back([&, p] {
+            move(partial[p].begin(), partial[p].end(), out.begin() + offsets[p]);
+        });
+    }
+    for (thread& t : pool) {
+        t.join();
+    }
+}
+
+// Множество на отсортированном непрерывном массиве.
+// Операции над множествами выполняются слиянием за O(n + m)
+// или галопированием за O(n log(m/n)), если одно множество намного меньше другого.
+template <typename T>
+struct SortedSet {
+    vector<T> values; // Элементы по возрастанию, без повторов
+
+    // Построение множества из произвольного набора за O(n log n)
+    static SortedSet fromValues(vector<T> items) {
+        SortedSet result;
+        sort(items.begin(), items.end());
+        items.erase(unique(items.begin(), items.end()), items.end());
+        result.values = move(items);
+        return result;
+    }
+
+    // Метод для добавления элемента в множество
+    void add(const T& value) {
+        auto it = lower_bound(values.begin(), values.end(), value);
+        if (it == values.end() || !(*it == value)) {
+            values.insert(it, value);
+        }
+    }
+
+    // Метод для проверки наличия элемента в множестве
+    bool contains(const T& value) const {
+        return binary_search(values.begin(), values.end(), value);
+    }
+
+    size_t size() const {
+        return values.size();
+    }
+
+    // Метод для вывода множества
+    void print() const {
+        for (const T& value : values) {
+            cout << value << " ";
+        }
+        cout << endl;
+    }
+
+    // Метод для пересечения множеств
+    SortedSet intersectionWith(const SortedSet& other) const {
+        SortedSet result;
+        intersectSorted(values, other.values, result.values);
+        return result;
+    }
+
+    // Метод для разности множеств
+    SortedSet differenceWith(const SortedSet& other) const {
+        SortedSet result;
+        differenceSorted(values, other.values, result.values);
+        return result;
+    }
+
+    // Метод для объединения множеств
+    SortedSet unionWith(const SortedSet& other) const {
+        SortedSet result;
+        unionSorted(values, other.values, result.values);
+        return result;
+    }
+
+    // Параллельное пересечение (threads <= 0 - по числу ядер)
+    SortedSet parallelIntersectionWith(const SortedSet& other, int threads = 0) const {
+        SortedSet result;
+        parallelSetOperation(values, other.values, result.values, threads,
+            [](const SortedRange<T>& a, const SortedRange<T>& b, vector<T>& out) { intersectRanges(a, b, out); });
+        return result;
+    }
+
+    // Параллельная разность
+    SortedSet parallelDifferenceWith(const SortedSet& other, int threads = 0) const {
+        SortedSet result;
+        parallelSetOperation(values, other.values, result.values, threads,
+            [](const SortedRange<T>& a, const SortedRange<T>& b, vector<T>& out) { differenceSorted(a, b, out); });
+        return result;
+    }
+
+    // Параллельное объединение
+    SortedSet parallelUnionWith(const SortedSet& other, int threads = 0) const {
+        SortedSet result;
+        parallelSetOperation(values, other.values, result.values, threads,
+            [](const SortedRange<T>& a, const SortedRange<T>& b, vector<T>& out) { unionSorted(a, b, out); });
+        return result;
+    }
+};
+
+// Для целых ключей пересечение выполняется SIMD-ядром
+template <>
+SortedSet<int32_t> SortedSet<int32_t>::intersectionWith(const SortedSet<int32_t>& other) const {
+    SortedSet<int32_t> result;
+    intersectSortedSimd(values, other.values, result.values);
+    return result;
+}
+
+// Контейнер сжатой битовой карты: младшие 16 бит значений одного блока из 65536 чисел.
+// Представление выбирается по размеру: массив (до 4096 значений), битовая карта (8 КБ)
+// или серии (пары "начало, длина - 1"), если значения идут сплошными диапазонами.
+struct RoaringContainer {
+    enum Type : uint8_t { ARRAY, BITMAP, RUN };
+    static constexpr uint32_t ARRAY_MAX = 4096;   // Максимум значений в массиве
+    static constexpr size_t BITMAP_WORDS = 1024;  // 65536 бит
+
+    Type type = ARRAY;
+    vector<uint16_t> data;   // ARRAY: значения по возрастанию; RUN: пары (начало, длина - 1)
+    vector<uint64_t> bits;   // BITMAP: биты значений
+    uint32_t cardinality = 0;
+
+    // Проверка наличия значения
+    bool contains(uint16_t low) const {
+        if (type == BITMAP) {
+            return (bits[low >> 6] >> (low & 63)) & 1;
+        }
+        if (type == ARRAY) {
+            return binary_search(data.begin(), data.end(), low);
+        }
+        // Серии: ищем последнюю серию с началом не больше low
+        size_t lo = 0, hi = data.size() / 2;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (data[mid * 2] <= low) lo = mid + 1; else hi = mid;
+        }
+        return lo > 0 && low - data[(lo - 1) * 2] <= data[(lo - 1) * 2 + 1];
+    }
+
+    // Битовая карта контейнера (для BITMAP - без копирования)
+    const vector<uint64_t>& asBitmap(vector<uint64_t>& scratch) const {
+        if (type == BITMAP) {
+            return bits;
+        }
+        scratch.assign(BITMAP_WORDS, 0);
+        if (type == ARRAY) {
+            for (uint16_t v : data) {
+                scratch[v >> 6] |= 1ull << (v & 63);
+            }
+        } else {
+            for (size_t r = 0; r < data.size(); r += 2) {
+                for (uint32_t v = data[r]; v <= (uint32_t)data[r] + data[r + 1]; ++v) {
+                    scratch[v >> 6] |= 1ull << (v & 63);
+                }
+            }
+        }
+        return scratch;
+    }
+
+    // Перевод в битовую карту
+    void toBitmap() {
+        if (type != BITMAP) {
+            vector<uint64_t> scratch;
+            asBitmap(scratch);
+            bits.swap(scratch);
+            data.clear();
+            data.shrink_to_fit();
+            type = BITMAP;
+        }
+    }
+
+    // Добавление значения; false, если оно уже было
+    bool add(uint16_t low) {
+        if (type == RUN) {
+            toBitmap();
+        }
+        if (type == BITMAP) {
+            uint64_t mask = 1ull << (low & 63);
+            if (bits[low >> 6] & mask) return false;
+            bits[low >> 6] |= mask;
+        } else {
+            auto it = lower_bound(data.begin(), data.end(), low);
+            if (it != data.end() && *it == low) return false;
+            data.insert(it, low);
+            if (data.size() > ARRAY_MAX) toBitmap();
+        }
+        ++cardinality;
+        return true;
+    }
+
+    // Выбор самого компактного представления по содержимому битовой карты
+    void optimize() {
+        vector<uint64_t> scratch;
+        const vector<uint64_t>& b = asBitmap(scratch);
+        // Количество серий - количество битов, перед которыми стоит ноль
+        size_t runs = 0;
+        for (size_t w = 0; w < BITMAP_WORDS; ++w) {
+            uint64_t prevBit = w > 0 ? b[w - 1] >> 63 : 0;
+            runs += __builtin_popcountll(b[w] & ~((b[w] << 1) | prevBit));
+        }
+        size_t arrayBytes = cardinality * 2, runBytes = runs * 4, bitmapBytes = BITMAP_WORDS * 8;
+        vector<uint16_t> out;
+        if (runBytes < arrayBytes && runBytes < bitmapBytes) {
+            for (uint32_t v = 0; v < 65536;) {
+                if (!((b[v >> 6] >> (v & 63)) & 1)) { ++v; continue; }
+                uint32_t start = v;
+                while (v < 65536 && ((b[v >> 6] >> (v & 63)) & 1)) ++v;
+                out.push_back((uint16_t)start);
+                out.push_back((uint16_t)(v - 1 - start));
+            }
+            data.swap(out);
+            type = RUN;
+        } else if (cardinality <= ARRAY_MAX) {
+            out.reserve(cardinality);
+            for (size_t w = 0; w < BITMAP_WORDS; ++w) {
+                for (uint64_t word = b[w]; word != 0; word &= word - 1) {
+                    out.push_back((uint16_t)(w * 64 + __builtin_ctzll(word)));
+                }
+            }
+            data.swap(out);
+            type = ARRAY;
+        } else {
+            toBitmap();
+            return;
+        }
+        data.shrink_to_fit();
+        bits.clear();
+        bits.shrink_to_fit();
+    }
+
+    // Объем памяти данных контейнера
+    size_t memoryBytes() const {
+        return sizeof(RoaringContainer) + data.capacity() * 2 + bits.capacity() * 8;
+    }
+
+    // Обход значений по возрастанию
+    template <typename Func>
+    void forEach(Func func) const {
+        if (type == ARRAY) {
+            for (uint16_t v : data) func(v);
+        } else if (type == RUN) {
+            for (size_t r = 0; r < data.size(); r += 2)
+                for (uint32_t v = data[r]; v <= (uint32_t)data[r] + data[r + 1]; ++v) func((uint16_t)v);
+        } else {
+            for (size_t w = 0; w < BITMAP_WORDS; ++w)
+                for (uint64_t word = bits[w]; word != 0; word &= word - 1) func((uint16_t)(w * 64 + __builtin_ctzll(word)));
+        }
+    }
+
+    // Операция над контейнерами: 0 - пересечение, 1 - объединение, 2 - разность.
+    // Два массива сливаются, иначе операция идет по словам битовых карт (цикл векторизуется).
+    static RoaringContainer combine(const RoaringContainer& a, const RoaringContainer& b, int op) {
+        RoaringContainer result;
+        if (a.type == ARRAY && b.type == ARRAY) {
+            if (op == 0) intersectSorted(a.data, b.data, result.data);
+            else if (op == 1) unionSorted(a.data, b.data, result.data);
+            else differenceSorted(a.data, b.data, result.data);
+            result.cardinality = (uint32_t)result.data.size();
+            if (result.cardinality > ARRAY_MAX) result.toBitmap();
+            return result;
+        }
+        if (op != 1 && a.type == ARRAY) {
+            // Массив фильтруется проверкой по второму контейнеру
+            for (uint16_t v : a.data) {
+                if (b.contains(v) == (op == 0)) result.data.push_back(v);
+            }
+            result.cardinality = (uint32_t)result.data.size();
+            return result;
+        }
+        vector<uint64_t> scratchA, scratchB;
+        const uint64_t* __restrict x = a.asBitmap(scratchA).data();
+        const uint64_t* __restrict y = b.asBitmap(scratchB).data();
+        result.type = BITMAP;
+        result.bits.resize(BITMAP_WORDS);
+        uint64_t* __restrict z = result.bits.data();
+        if (op == 0) for (size_t w = 0; w < BITMAP_WORDS; ++w) z[w] = x[w] & y[w];
+        else if (op == 1) for (size_t w = 0; w < BITMAP_WORDS; ++w) z[w] = x[w] | y[w];
+        else for (size_t w = 0; w < BITMAP_WORDS; ++w) z[w] = x[w] & ~y[w];
+        uint32_t count = 0;
+        for (size_t w = 0; w < BITMAP_WORDS; ++w) count += __builtin_popcountll(z[w]);
+        result.cardinality = count;
+        if (count <= ARRAY_MAX) result.optimize(); // Разреженный результат хранится массивом
+        return result;
+    }
+};
+
+// Сжатая битовая карта в стиле Roaring для 32-битных чисел:
+// старшие 16 бит выбирают контейнер, младшие хранятся в нем
+struct RoaringSet {
+    vector<uint16_t> keys;               // Старшие 16 бит по возрастанию
+    vector<RoaringContainer> containers; // Контейнеры в порядке keys
+
+    // Построение из произвольного набора с выбором лучшего представления каждого контейнера
+    static RoaringSet fromValues(vector<uint32_t> items) {
+        sort(items.begin(), items.end());
+        items.erase(unique(items.begin(), items.end()), items.end());
+        RoaringSet result;
+        for (uint32_t v : items) {
+            if (result.keys.empty() || result.keys.back() != (v >> 16)) {
+                result.keys.push_back((uint16_t)(v >> 16));
+                result.containers.emplace_back();
+            }
+            RoaringContainer& c = result.containers.back();
+            if (c.type == RoaringContainer::ARRAY && c.data.size() == RoaringContainer::ARRAY_MAX) c.toBitmap();
+            if (c.type == RoaringContainer::ARRAY) c.data.push_back((uint16_t)v);
+            else c.bits[(v & 0xFFFF) >> 6] |= 1ull << (v & 63);
+            ++c.cardinality;
+        }
+        for (RoaringContainer& c : result.containers) c.optimize();
+        return result;
+    }
+
+    // Позиция контейнера с ключом key (или место для вставки)
+    size_t findKey(uint16_t key) const {
+        return lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    }
+
+    bool contains(uint32_t value) const {
+        size_t i = findKey((uint16_t)(value >> 16));
+        return i < keys.size() && keys[i] == (value >> 16) && containers[i].contains((uint16_t)value);
+    }
+
+    void add(uint32_t value) {
+        size_t i = findKey((uint16_t)(value >> 16));
+        if (i == keys.size() || keys[i] != (value >> 16)) {
+            keys.insert(keys.begin() + i, (uint16_t)(value >> 16));
+            containers.insert(containers.begin() + i, RoaringContainer());
+        }
+        containers[i].add((uint16_t)value);
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const RoaringContainer& c : containers) total += c.cardinality;
+        return total;
+    }
+
+    size_t memoryBytes() const {
+        size_t total = keys.capacity() * 2;
+        for (const RoaringContainer& c : containers) total += c.memoryBytes();
+        return total;
+    }
+
+    template <typename Func>
+    void forEach(Func func) const {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            uint32_t high = (uint32_t)keys[i] << 16;
+            containers[i].forEach([&](uint16_t low) { func(high | low); });
+        }
+    }
+
+    // Операция над множествами слиянием списков ключей
+    RoaringSet combine(const RoaringSet& other, int op) const {
+        RoaringSet result;
+        size_t i = 0, j = 0;
+        auto append = [&](uint16_t key, RoaringContainer&& c) {
+            if (c.cardinality > 0) {
+                result.keys.push_back(key);
+                result.containers.push_back(move(c));
+            }
+        };
+        while (i < keys.size() || j < other.keys.size()) {
+            if (j == other.keys.size() || (i < keys.size() && keys[i] < other.keys[j])) {
+                if (op != 0) append(keys[i], RoaringContainer(containers[i])); // Только в первом
+                ++i;
+            } else if (i == keys.size() || other.keys[j] < keys[i]) {
+                if (op == 1) append(other.keys[j], RoaringContainer(other.containers[j])); // Только во втором
+                ++j;
+            } else {
+                append(keys[i], RoaringContainer::combine(containers[i], other.containers[j], op));
+                ++i;
+                ++j;
+            }
+        }
+        return result;
+    }
+
+    RoaringSet intersectionWith(const RoaringSet& other) const { return combine(other, 0); }
+    RoaringSet unionWith(const RoaringSet& other) const { return combine(other, 1); }
+    RoaringSet differenceWith(const RoaringSet& other) const { return combine(other, 2); }
+};
+
+// Распознавание целого ключа: десятичная запись без знака и ведущих нулей, не больше 2^32 - 1
+// (иначе строка не восстанавливается из числа без потерь)
+bool parseIntegerKey(const string& value, uint32_t& key) {
+    if (value.empty() || value.size() > 10 || (value.size() > 1 && value[0] == '0')) {
+        return false;
+    }
+    uint64_t result = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9') return false;
+        result = result * 10 + (c - '0');
+    }
+    if (result > UINT32_MAX) {
+        return false;
+    }
+    key = (uint32_t)result;
+    return true;
+}
+
+// Множество строк, в котором целые ключи хранятся в сжатой битовой карте,
+// а остальные строки - в отсортированном массиве
+struct CompactSet {
+    RoaringSet numbers;          // Целые ключи
+    SortedSet<string> strings;   // Прочие строки
+
+    static CompactSet fromValues(const vector<string>& items) {
+        CompactSet result;
+        vector<uint32_t> ids;
+        vector<string> others;
+        for (const string& item : items) {
+            uint32_t key;
+            if (parseIntegerKey(item, key)) ids.push_back(key);
+            else others.push_back(item);
+        }
+        result.numbers = RoaringSet::fromValues(move(ids));
+        result.strings = SortedSet<string>::fromValues(move(others));
+        return result;
+    }
+
+    void add(const string& value) {
+        uint32_t key;
+        if (parseIntegerKey(value, key)) numbers.add(key);
+        else strings.add(value);
+    }
+
+    bool contains(const string& value) const {
+        uint32_t key;
+        return parseIntegerKey(value, key) ? numbers.contains(key) : strings.contains(value);
+    }
+
+    size_t size() const {
+        return numbers.size() + strings.size();
+    }
+
+    void print() const {
+        numbers.forEach([](uint32_t v) { cout << v << " "; });
+        for (const string& v : strings.values) cout << v << " ";
+        cout << endl;
+    }
+
+    CompactSet intersectionWith(const CompactSet& other) const {
+        return CompactSet{numbers.intersectionWith(other.numbers), strings.intersectionWith(other.strings)};
+    }
+
+    CompactSet differenceWith(const CompactSet& other) const {
+        return CompactSet{numbers.differenceWith(other.numbers), strings.differenceWith(other.strings)};
+    }
+
+    CompactSet unionWith(const CompactSet& other) const {
+        return CompactSet{numbers.unionWith(other.numbers), strings.unionWith(other.strings)};
+    }
+};
+
+// Арена интернированных строк: байты всех строк лежат в одном растущем блоке,
+// каждая различная строка хранится один раз и получает 32-битный дескриптор.
+// Равенство строк одной арены - равенство дескрипторов; память освобождается целиком.
+struct StringArena {
+    vector<char> bytes;        // Байты строк подряд
+    vector<uint32_t> offsets;  // Начало строки с дескриптором h - offsets[h], конец - offsets[h + 1]
+    vector<uint32_t> hashes;   // Хеш строки по дескриптору (для сравнения и роста таблицы)
+    vector<uint32_t> slots;    // Таблица интернирования: дескриптор + 1 или 0 (пусто)
+
+    StringArena() {
+        offsets.push_back(0);
+    }
+
+    static uint32_t hashOf(string_view value) {
+        uint64_t h = 1469598103934665603ull; // FNV-1a
+        for (unsigned char c : value) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return (uint32_t)(h ^ (h >> 32));
+    }
+
+    size_t size() const {
+        return offsets.size() - 1;
+    }
+
+    // Строка по дескриптору
+    string_view get(uint32_t handle) const {
+        return string_view(bytes.data() + offsets[handle], offsets[handle + 1] - offsets[handle]);
+    }
+
+    // Поиск слота таблицы для строки (занятого ею или пустого)
+    size_t probe(string_view value, uint32_t hash) const {
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            uint32_t slot = slots[i];
+            if (slot == 0 || (hashes[slot - 1] == hash && get(slot - 1) == value)) {
+                return i;
+            }
+        }
+    }
+
+    // Поиск дескриптора без добавления строки
+    bool find(string_view value, uint32_t& handle) const {
+        if (slots.empty()) {
+            return false;
+        }
+        uint32_t slot = slots[probe(value, hashOf(value))];
+        handle = slot - 1;
+        return slot != 0;
+    }
+
+    // Дескриптор строки; новая строка дописывается в арену
+    uint32_t intern(string_view value) {
+        if ((size() + 1) * 2 > slots.size()) {
+            // Таблица заполнена наполовину: удваиваем и перераскладываем дескрипторы
+            vector<uint32_t> bigger(max<size_t>(16, slots.size() * 2), 0);
+            size_t mask = bigger.size() - 1;
+            for (uint32_t h = 0; h < size(); ++h) {
+                size_t i = hashes[h] & mask;
+                while (bigger[i] != 0) i = (i + 1) & mask;
+                bigger[i] = h + 1;
+            }
+            slots.swap(bigger);
+        }
+        uint32_t hash = hashOf(value);
+        size_t i = probe(value, hash);
+        if (slots[i] != 0) {
+            return slots[i] - 1; // Строка уже есть: повтор не занимает памяти
+        }
+        if (bytes.size() + value.size() > UINT32_MAX) {
+            throw length_error("Арена строк переполнена");
+        }
+        uint32_t handle = (uint32_t)size();
+        bytes.insert(bytes.end(), value.begin(), value.end());
+        offsets.push_back((uint32_t)bytes.size());
+        hashes.push_back(hash);
+        slots[i] = handle + 1;
+        return handle;
+    }
+
+    // Освобождение всей арены
+    void release() {
+        vector<char>().swap(bytes);
+        vector<uint32_t>(1, 0).swap(offsets);
+        vector<uint32_t>().swap(hashes);
+        vector<uint32_t>().swap(slots);
+    }
+
+    size_t memoryBytes() const {
+        return bytes.capacity() + (offsets.capacity() + hashes.capacity() + slots.capacity()) * 4;
+    }
+};
+
+// Множество строк, хранящее дескрипторы арены: элемент занимает 4 байта,
+// сравнение элементов - сравнение целых. Множества в одной операции должны использовать одну арену.
+struct InternedSet {
+    StringArena* arena = nullptr;
+    SortedSet<uint32_t> handles; // Дескрипторы по возрастанию
+
+    InternedSet(StringArena& a) : arena(&a) {}
+
+    InternedSet(StringArena& a, SortedSet<uint32_t>&& h) : arena(&a), handles(move(h)) {}
+
+    void add(const string& value) {
+        handles.add(arena->intern(value));
+    }
+
+    bool contains(const string& value) const {
+        uint32_t handle;
+        return arena->find(value, handle) && handles.contains(handle);
+    }
+
+    size_t size() const {
+        return handles.size();
+    }
+
+    void print() const {
+        for (uint32_t handle : handles.values) {
+            cout << arena->get(handle) << " ";
+        }
+        cout << endl;
+    }
+
+    InternedSet intersectionWith(const InternedSet& other) const {
+        return InternedSet(*arena, handles.intersectionWith(other.handles));
+    }
+
+    InternedSet differenceWith(const InternedSet& other) const {
+        return InternedSet(*arena, handles.differenceWith(other.handles));
+    }
+
+    InternedSet unionWith(const InternedSet& other) const {
+        return InternedSet(*arena, handles.unionWith(other.handles));
+    }
+};
+
+// Поток элементов множества по возрастанию (узел ленивого выражения)
+template <typename T>
+struct SetStream {
+    virtual ~SetStream() {}
+    virtual const T* current() const = 0;   // Текущий элемент или nullptr, если поток исчерпан
+    virtual void advance() = 0;             // Переход к следующему элементу
+    virtual void seek(const T& target) = 0; // Переход к первому элементу не меньше target
+};
+
+// Лист выражения: обход отсортированного массива без копирования
+template <typename T>
+struct LeafStream : SetStream<T> {
+    const vector<T>& values;
+    size_t pos = 0;
+
+    LeafStream(const vector<T>& v) : values(v) {}
+
+    const T* current() const override {
+        return pos < values.size() ? &values[pos] : nullptr;
+    }
+
+    void advance() override {
+        ++pos;
+    }
+
+    void seek(const T& target) override {
+        if (pos < values.size() && values[pos] < target) {
+            pos = gallop(values, pos, target);
+        }
+    }
+};
+
+// Объединение двух потоков
+template <typename T>
+struct UnionStream : SetStream<T> {
+    unique_ptr<SetStream<T>> left, right;
+    const T* value = nullptr;
+
+    UnionStream(unique_ptr<SetStream<T>> l, unique_ptr<SetStream<T>> r) : left(move(l)), right(move(r)) {
+        settle();
+    }
+
+    // Текущий элемент - меньший из текущих элементов потоков
+    void settle() {
+        const T* a = left->current();
+        const T* b = right->current();
+        value = (a == nullptr) ? b : (b == nullptr || !(*b < *a)) ? a : b;
+    }
+
+    const T* current() const override {
+        return value;
+    }
+
+    void advance() override {
+        const T* a = left->current();
+        const T* b = right->current();
+        bool advanceLeft = a != nullptr && !(*value < *a) && !(*a < *value);
+        bool advanceRight = b != nullptr && !(*value < *b) && !(*b < *value);
+        if (advanceLeft) left->advance();
+        if (advanceRight) right->advance();
+        settle();
+    }
+
+    void seek(const T& target) override {
+        left->seek(target);
+        right->seek(target);
+        settle();
+    }
+};
+
+// Пересечение двух потоков: потоки поочередно догоняют друг друга через seek
+template <typename T>
+struct IntersectionStream : SetStream<T> {
+    unique_ptr<SetStream<T>> left, right;
+
+    IntersectionStream(unique_ptr<SetStream<T>> l, unique_ptr<SetStream<T>> r) : left(move(l)), right(move(r)) {
+        settle();
+    }
+
+    void settle() {
+        while (true) {
+            const T* a = left->current();
+            const T* b = right->current();
+            if (a == nullptr || b == nullptr) {
+                return;
+            }
+            if (*a < *b) {
+                left->seek(*b);
+            } else if (*b < *a) {
+                right->seek(*a);
+            } else {
+                return; // Элемент есть в обоих потоках
+            }
+        }
+    }
+
+    const T* current() const override {
+        return right->current() != nullptr ? left->current() : nullptr;
+    }
+
+    void advance() override {
+        left->advance();
+        right->advance();
+        settle();
+    }
+
+    void seek(const T& target) override {
+        left->seek(target);
+        right->seek(target);
+        settle();
+    }
+};
+
+// Разность двух потоков: элементы левого, которых нет в правом
+template <typename T>
+struct DifferenceStream : SetStream<T> {
+    unique_ptr<SetStream<T>> left, right;
+
+    DifferenceStream(unique_ptr<SetStream<T>> l, unique_ptr<SetStream<T>> r) : left(move(l)), right(move(r)) {
+        settle();
+    }
+
+    void settle() {
+        while (const T* a = left->current()) {
+            right->seek(*a);
+            const T* b = right->current();
+            if (b == nullptr || *a < *b) {
+                return; // Элемента нет в правом потоке
+            }
+            left->advance();
+        }
+    }
+
+    const T* current() const override {
+        return left->current();
+    }
+
+    void advance() override {
+        left->advance();
+        settle();
+    }
+
+    void seek(const T& target) override {
+        left->seek(target);
+        settle();
+    }
+};
+
+// Ленивое выражение над множествами: дерево объединений, пересечений и разностей.
+// Ничего не вычисляется до evaluate/forEach; вычисление - один потоковый проход
+// по входным множествам без промежуточных результатов.
+template <typename T>
+struct SetExpr {
+    unique_ptr<SetStream<T>> stream;
+
+    // Обход элементов результата по возрастанию без материализации
+    template <typename Func>
+    void forEach(Func func) {
+        for (const T* value = stream->current(); value != nullptr; stream->advance(), value = stream->current()) {
+            func(*value);
+        }
+    }
+
+    // Вычисление выражения в новое множество (результат возвращается перемещением)
+    SortedSet<T> evaluate() {
+        SortedSet<T> result;
+        forEach([&](const T& value) { result.values.push_back(value); });
+        return result;
+    }
+};
+
+// Лист выражения; множество должно жить до вычисления выражения
+template <typename T>
+SetExpr<T> expr(const SortedSet<T>& set) {
+    return SetExpr<T>{make_unique<LeafStream<T>>(set.values)};
+}
+
+template <typename T>
+SetExpr<T> operator|(SetExpr<T> a, SetExpr<T> b) {
+    return SetExpr<T>{make_unique<UnionStream<T>>(move(a.stream), move(b.stream))};
+}
+
+template <typename T>
+SetExpr<T> operator&(SetExpr<T> a, SetExpr<T> b) {
+    return SetExpr<T>{make_unique<IntersectionStream<T>>(move(a.stream), move(b.stream))};
+}
+
+template <typename T>
+SetExpr<T> operator-(SetExpr<T> a, SetExpr<T> b) {
+    return SetExpr<T>{make_unique<DifferenceStream<T>>(move(a.stream), move(b.stream))};
+}
+
+// Время выполнения func в миллисекундах
+template <typename Func>
+double measureMs(Func func) {
+    auto begin = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+// Бенчмарк операций при разных соотношениях размеров множеств
+void runBenchmark() {
+    const size_t sizes[] = {10000, 1000000};     // Размер большего множества
+    const size_t ratios[] = {1, 10, 100, 1000};  // Во сколько раз меньшее множество меньше
+    const size_t linkedLimit = 10000;            // Дальше исходный Set слишком медленный
+    unsigned seed = 1;
+    auto next = [&] { seed = seed * 1103515245u + 12345u; return (int32_t)(seed >> 1) % 4000000; };
+
+    for (size_t large : sizes) {
+        for (size_t ratio : ratios) {
+            size_t small = large / ratio;
+            vector<int32_t> smallInts(small), largeInts(large);
+            for (auto& v : smallInts) v = next();
+            for (auto& v : largeInts) v = next();
+            vector<string> smallStrings, largeStrings;
+            for (int32_t v : smallInts) smallStrings.push_back(to_string(v));
+            for (int32_t v : largeInts) largeStrings.push_back(to_string(v));
+
+            auto a = SortedSet<int32_t>::fromValues(smallInts);
+            auto b = SortedSet<int32_t>::fromValues(largeInts);
+            auto as = SortedSet<string>::fromValues(smallStrings);
+            auto bs = SortedSet<string>::fromValues(largeStrings);
+
+            size_t checksum = 0;
+            double simdMs = measureMs([&] { checksum += a.intersectionWith(b).size(); });
+            double scalarMs = measureMs([&] {
+                vector<int32_t> out;
+                intersectSorted(a.values, b.values, out);
+                checksum += out.size();
+            });
+            double stringMs = measureMs([&] {
+                checksum += as.intersectionWith(bs).size();
+                checksum += as.differenceWith(bs).size();
+                checksum += as.unionWith(bs).size();
+            });
+
+            cout << "размеры " << small << " и " << large << ": пересечение int SIMD " << simdMs
+                 << " мс, int слиянием " << scalarMs << " мс; строки (пересечение+разность+объединение) "
+                 << stringMs << " мс";
+            if (large <= linkedLimit) {
+                Set x, y;
+                double buildMs = measureMs([&] {
+                    for (auto& v : smallStrings) x.add(v);
+                    for (auto& v : largeStrings) y.add(v);
+                });
+                double linkedMs = measureMs([&] {
+                    Set i = x.intersectionWith(y);
+                    Set d = x.differenceWith(y);
+                });
+                cout << "; исходный Set: построение " << buildMs << " мс, пересечение+разность " << linkedMs << " мс";
+            }
+            cout << " (контрольная сумма " << checksum << ")" << endl;
+        }
+    }
+}
+
+// Бенчмарк 5-местного выражения ((a | b) & (c | d)) - e: цепочка вызовов против ленивого выражения
+void runExpressionBenchmark() {
+    const size_t n = 1000000; // Размер каждого входного множества
+    unsigned seed = 3;
+    SortedSet<string> inputs[5];
+    for (auto& set : inputs) {
+        vector<string> items(n);
+        for (auto& item : items) {
+            seed = seed * 1103515245u + 12345u;
+            item = to_string((seed >> 1) % (3 * n));
+        }
+        set = SortedSet<string>::fromValues(move(items));
+    }
+    auto& [a, b, c, d, e] = inputs;
+
+    size_t base = heapBytes;
+    heapPeakBytes = heapBytes.load();
+    size_t chainedSize = 0;
+    double chainedMs = measureMs([&] {
+        chainedSize = a.unionWith(b).intersectionWith(c.unionWith(d)).differenceWith(e).size();
+    });
+    size_t chainedPeak = heapPeakBytes - base;
+
+    heapPeakBytes = heapBytes.load();
+    size_t lazySize = 0;
+    double lazyMs = measureMs([&] {
+        lazySize = (((expr(a) | expr(b)) & (expr(c) | expr(d))) - expr(e)).evaluate().size();
+    });
+    size_t lazyPeak = heapPeakBytes - base;
+
+    cout << "Цепочка вызовов:      " << chainedMs << " мс, пик памяти " << chainedPeak / 1024 << " КБ, элементов "
+         << chainedSize << endl;
+    cout << "Ленивое выражение:    " << lazyMs << " мс, пик памяти " << lazyPeak / 1024 << " КБ, элементов "
+         << lazySize << endl;
+}
+
+// Бенчмарк параллельных операций на 10^7-элементных множествах при разном числе потоков
+void runParallelBenchmark() {
+    const size_t n = 10000000;
+    unsigned seed = 17;
+    vector<int32_t> x(n), y(n);
+    for (auto& v : x) { seed = seed * 1103515245u + 12345u; v = (int32_t)(seed >> 1) % (3 * (int32_t)n); }
+    for (auto& v : y) { seed = seed * 1103515245u + 12345u; v = (int32_t)(seed >> 1) % (3 * (int32_t)n); }
+    auto a = SortedSet<int32_t>::fromValues(move(x));
+    auto b = SortedSet<int32_t>::fromValues(move(y));
+
+    auto serialI = a.intersectionWith(b);
+    auto serialD = a.differenceWith(b);
+    auto serialU = a.unionWith(b);
+    int maxThreads = max(4u, thread::hardware_concurrency());
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        bool same = true;
+        double intersectMs = measureMs([&] { same &= a.parallelIntersectionWith(b, threads).values == serialI.values; });
+        double differenceMs = measureMs([&] { same &= a.parallelDifferenceWith(b, threads).values == serialD.values; });
+        double unionMs = measureMs([&] { same &= a.parallelUnionWith(b, threads).values == serialU.values; });
+        cout << "потоков " << threads << ": пересечение " << intersectMs << " мс, разность " << differenceMs
+             << " мс, объединение " << unionMs << " мс" << (same ? "" : " (РЕЗУЛЬТАТ НЕ СОВПАДАЕТ)") << endl;
+    }
+}
+
+// Бенчмарк сжатой битовой карты: память на элемент и скорость операций
+// в сравнении с множествами строк для числовых идентификаторов
+void runBitmapBenchmark() {
+    const size_t n = 1000000;
+    unsigned seed = 23;
+    vector<string> xs, ys;
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        xs.push_back(to_string((seed >> 1) % (4 * n))); // Случайные идентификаторы
+        ys.push_back(to_string(n + i));                 // Сплошной диапазон
+    }
+
+    // Память исходного Set на 10^4 элементах (построение больших списков слишком долгое)
+    size_t linkedCount = 10000;
+    size_t before = heapBytes;
+    Set* linked = new Set;
+    for (size_t i = 0; i < linkedCount; ++i) linked->add(ys[i]);
+    double linkedPerElement = (double)(heapBytes - before) / linkedCount;
+    delete linked;
+
+    before = heapBytes;
+    auto sa = SortedSet<string>::fromValues(xs);
+    auto sb = SortedSet<string>::fromValues(ys);
+    double sortedPerElement = (double)(heapBytes - before) / (sa.size() + sb.size());
+
+    auto ca = CompactSet::fromValues(xs);
+    auto cb = CompactSet::fromValues(ys);
+    double compactPerElement = (double)(ca.numbers.memoryBytes() + cb.numbers.memoryBytes()) / (ca.size() + cb.size());
+
+    size_t checksum = 0;
+    double sortedMs = measureMs([&] {
+        checksum += sa.intersectionWith(sb).size() + sa.unionWith(sb).size() + sa.differenceWith(sb).size();
+    });
+    double compactMs = measureMs([&] {
+        checksum -= ca.intersectionWith(cb).size() + ca.unionWith(cb).size() + ca.differenceWith(cb).size();
+    });
+
+    cout << "Память на элемент: Set " << linkedPerElement << " Б, SortedSet<string> " << sortedPerElement
+         << " Б, CompactSet " << compactPerElement << " Б" << endl;
+    cout << "Пересечение+объединение+разность 10^6 идентификаторов: SortedSet<string> " << sortedMs
+         << " мс, CompactSet " << compactMs << " мс (контрольная разность " << checksum << ")" << endl;
+}
+
+// Резидентная память процесса в байтах (Linux, /proc/self/statm)
+size_t residentBytes() {
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * 4096;
+}
+
+// Бенчмарк арены: выделения памяти и прирост RSS при построении двух множеств по n элементов
+void runArenaBenchmark(size_t n) {
+    // Ключ i записывается в буфер без выделения памяти; строки длиннее SSO и повторяются
+    char buffer[64];
+    auto key = [&](size_t i) {
+        int length = snprintf(buffer, sizeof(buffer), "user-session-%llu", (unsigned long long)(i % (n * 3 / 4) + 1000000000ull));
+        return string_view(buffer, length);
+    };
+    auto report = [](const char* name, size_t allocations, size_t heap, size_t rss, double ms) {
+        cout << name << ": выделений " << allocations << ", куча " << heap / (1 << 20) << " МБ, прирост RSS "
+             << rss / (1 << 20) << " МБ, " << ms << " мс" << endl;
+    };
+
+    {
+        size_t allocations = heapAllocations, heap = heapBytes, rss = residentBytes();
+        SortedSet<string> a, b;
+        double ms = measureMs([&] {
+            vector<string> xs(n), ys(n);
+            for (size_t i = 0; i < n; ++i) xs[i] = key(i);
+            for (size_t i = 0; i < n; ++i) ys[i] = key(i + n / 2);
+            a = SortedSet<string>::fromValues(move(xs));
+            b = SortedSet<string>::fromValues(move(ys));
+        });
+        report("SortedSet<string>", heapAllocations - allocations, heapBytes - heap, residentBytes() - rss, ms);
+        double freeMs = measureMs([&] { a = SortedSet<string>(); b = SortedSet<string>(); });
+        cout << "  освобождение " << freeMs << " мс" << endl;
+    }
+    malloc_trim(0); // Возвращаем освобожденную память системе, чтобы замер RSS был честным
+
+    {
+        size_t allocations = heapAllocations, heap = heapBytes, rss = residentBytes();
+        StringArena arena;
+        InternedSet a(arena), b(arena);
+        double ms = measureMs([&] {
+            vector<uint32_t> xs(n), ys(n);
+            for (size_t i = 0; i < n; ++i) xs[i] = arena.intern(key(i));
+            for (size_t i = 0; i < n; ++i) ys[i] = arena.intern(key(i + n / 2));
+            a.handles = SortedSet<uint32_t>::fromValues(move(xs));
+            b.handles = SortedSet<uint32_t>::fromValues(move(ys));
+        });
+        report("InternedSet", heapAllocations - allocations, heapBytes - heap, residentBytes() - rss, ms);
+        size_t distinct = arena.size();
+        double freeMs = measureMs([&] { arena.release(); });
+        cout << "  освобождение арены " << freeMs << " мс (различных строк " << distinct << ")" << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench-arena") {
+        // Замер арены строк: --bench-arena [число элементов, по умолчанию 10^7]
+        runArenaBenchmark(argc > 2 ? strtoull(argv[2], nullptr, 10) : 10000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runBenchmark(); // Режим замера производительности
+        runExpressionBenchmark();
+        runParallelBenchmark();
+        runBitmapBenchmark();
+        return 0;
+    }
+
+
+    Set set1;
+    Set set2;
+
+    // Добавляем элементы в первое множество
+    set1.add("1");
+    set1.add("2");
+    set1.add("3");
+    set1.add("4");
+    set1.add("5");
+
+    // Добавляем элементы во второе множество
+    set2.add("3");
+    set2.add("4");
+    set2.add("5");
+    set2.add("6");
+    set2.add("7");
+
+    cout << "Первое множество: ";
+    set1.print();
+
+    cout << "Второе множество: ";
+    set2.print();
+
+    // Пересечение множеств
+    Set intersectionSet = set1.intersectionWith(set2);
+    cout << "Пересечение множеств: ";
+    intersectionSet.print();
+
+    // Разность множеств
+    Set differenceSet = set1.differenceWith(set2);
+    cout << "Разность множеств (set1 - set2): ";
+    differenceSet.print();
+
+    // Объединение множеств
+    Set unionSet = set1.unionWith(set2);
+    cout << "Объединение множеств: ";
+    unionSet.print();
+
+    return 0;
+}
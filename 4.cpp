@@ -1,92 +1,888 @@
-#include <iostream> // Подключаем библиотеку для ввода-вывода
-#include <string>   // Подключаем библиотеку для работы со строками
-
-using namespace std; // Используем стандартное пространство имен
-
-// Структура для хранения массива строк
-struct Array {
-    string* data; // Указатель на массив строк
-    int size;     // Размер массива
-
-    // Конструктор для инициализации массива
-    Array(int s) : size(s) {
-        data = new string[size]; // Выделяем память под массив строк размером size
-    }
-
-    // Деструктор для освобождения памяти
-    ~Array() {
-        delete[] data; // Освобождаем память, выделенную под массив строк
-    }
-};
-
-// Функция для сравнения строки с шаблоном
-bool matches(const string& str, const string& pattern) {
-    int sLen = str.length(); // Длина строки
-    int pLen = pattern.length(); // Длина шаблона
-    
-    // Создаем двумерный массив для хранения результатов сопоставления
-    bool** dp = new bool*[sLen + 1]; // Размер массива по строкам (sLen + 1)
-    for (int i = 0; i <= sLen; ++i) {
-        dp[i] = new bool[pLen + 1]; // Размер массива по столбцам (pLen + 1)
-    }
-
-    // Инициализация
-    dp[0][0] = true; // Пустая строка соответствует пустому шаблону
-
-    // Обработка шаблона, начинающегося с '*'
-    for (int j = 1; j <= pLen; ++j) {
-        if (pattern[j - 1] == '*') {
-            dp[0][j] = dp[0][j - 1]; // '*' может соответствовать пустой строке
-        }
-    }
-
-    // Заполнение таблицы сопоставления
-    for (int i = 1; i <= sLen; ++i) {
-        for (int j = 1; j <= pLen; ++j) {
-            // Проверяем, совпадает ли текущий символ строки с символом шаблона
-            if (pattern[j - 1] == str[i - 1] || pattern[j - 1] == '?') {
-                dp[i][j] = dp[i - 1][j - 1]; // Совпадение символов
-            } 
-            // Если текущий символ шаблона - '*', проверяем два случая:
-            else if (pattern[j - 1] == '*') {
-                dp[i][j] = dp[i - 1][j] || dp[i][j - 1]; // '*' может соответствовать одному или более символам
-            } else {
-                dp[i][j] = false; // Нет совпадения
-            }
-        }
-    }
-
-    bool result = dp[sLen][pLen]; // Получаем результат сопоставления (соответствует ли вся строка шаблону)
-    
-    // Освобождение памяти, выделенной под двумерный массив
-    for (int i = 0; i <= sLen; ++i) {
-        delete[] dp[i]; // Освобождаем каждую строку
-    }
-    delete[] dp; // Освобождаем основной массив указателей
-
-    return result; // Возвращаем результат сопоставления (true или false)
-}
-
-int main() {
-    string input; // Переменная для хранения строки на проверку
-    string pattern; // Переменная для хранения шаблона
-
-    // Запрашиваем у пользователя строку для проверки
-    cout << "Введите строку для проверки: ";
-    getline(cin, input); // Считываем строку с пробелами
-
-    // Запрашиваем у пользователя шаблон
-    cout << "Введите шаблон (используйте '*' для любой последовательности и '?' для одного символа): ";
-    getline(cin, pattern); // Считываем шаблон с пробелами
-
-    // Проверяем соответствие введенной строки с шаблоном
-    if (matches(input, pattern)) {
-        // Если строка соответствует шаблону, выводим соответствующее сообщение
-        cout << "\"" << input << "\" соответствует шаблону \"" << pattern << "\"" << endl;
-    } else {
-        // Если строка не соответствует шаблону, выводим соответствующее сообщение
-        cout << "\"" << input << "\" не соответствует шаблону \"" << pattern << "\"" << endl;
-    }
-
-    return 0; // Завершение программы
-}
+#include <iostream> // Подключаем библиотеку для ввода-вывода
+#include <string>   // Подключаем библиотеку для работы со строками
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std; // Используем стандартное пространство имен
+
+// Структура для хранения массива строк
+struct Array {
+    string* data; // Указатель на массив строк
+    int size;     // Размер массива
+
+    // Конструктор для инициализации массива
+    Array(int s) : size(s) {
+        data = new string[size]; // Выделяем память под массив строк размером size
+    }
+
+    // Деструктор для освобождения памяти
+    ~Array() {
+        delete[] data; // Освобождаем память, выделенную под массив строк
+    }
+};
+
+// Функция для сравнения строки с шаблоном
+bool matches(const string& str, const string& pattern) {
+    int sLen = str.length(); // Длина строки
+    int pLen = pattern.length(); // Длина шаблона
+    
+    // Создаем двумерный массив для хранения результатов сопоставления
+    bool** dp = new bool*[sLen + 1]; // Размер массива по строкам (sLen + 1)
+    for (int i = 0; i <= sLen; ++i) {
+        dp[i] = new bool[pLen + 1](); // Размер массива по столбцам (pLen + 1), все значения false
+    }
+
+    // Инициализация
+    dp[0][0] = true; // Пустая строка соответствует пустому шаблону
+
+    // Обработка шаблона, начинающегося с '*'
+    for (int j = 1; j <= pLen; ++j) {
+        if (pattern[j - 1] == '*') {
+            dp[0][j] = dp[0][j - 1]; // '*' может соответствовать пустой строке
+        }
+    }
+
+    // Заполнение таблицы сопоставления
+    for (int i = 1; i <= sLen; ++i) {
+        for (int j = 1; j <= pLen; ++j) {
+            // Проверяем, совпадает ли текущий символ строки с символом шаблона
+            if (pattern[j - 1] == str[i - 1] || pattern[j - 1] == '?') {
+                dp[i][j] = dp[i - 1][j - 1]; // Совпадение символов
+            } 
+            // Если текущий символ шаблона - '*', проверяем два случая:
+            else if (pattern[j - 1] == '*') {
+                dp[i][j] = dp[i - 1][j] || dp[i][j - 1]; // '*' может соответствовать одному или более символам
+            } else {
+                dp[i][j] = false; // Нет совпадения
+            }
+        }
+    }
+
+    bool result = dp[sLen][pLen]; // Получаем результат сопоставления (соответствует ли вся строка шаблону)
+    
+    // Освобождение памяти, выделенной под двумерный массив
+    for (int i = 0; i <= sLen; ++i) {
+        delete[] dp[i]; // Освобождаем каждую строку
+    }
+    delete[] dp; // Освобождаем основной массив указателей
+
+    return result; // Возвращаем результат сопоставления (true или false)
+}
+
+// Поиск needle в text[from, to) - позиция первого вхождения или string::npos.
+// Векторный вариант сравнивает первый и последний символ образца сразу в 32 (AVX2)
+// или 16 (SSE2) позициях, и только кандидаты проверяются memcmp.
+size_t findLiteral(string_view text, size_t from, size_t to, string_view needle) {
+    size_t k = needle.size();
+    if (k == 0) {
+        return from;
+    }
+    if (to < from || to - from < k) {
+        return string::npos;
+    }
+    const char* data = text.data();
+    size_t last = to - k; // Последняя возможная позиция начала
+    size_t i = from;
+#if defined(__AVX2__)
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i final = _mm256_set1_epi8(needle[k - 1]);
+    for (; i + 31 <= last; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(data + i + k - 1));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, final)));
+        while (mask != 0) {
+            size_t pos = i + __builtin_ctz(mask);
+            if (memcmp(data + pos, needle.data(), k) == 0) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i final = _mm_set1_epi8(needle[k - 1]);
+    for (; i + 15 <= last; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(data + i + k - 1));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, final)));
+        while (mask != 0) {
+            size_t pos = i + __builtin_ctz(mask);
+            if (memcmp(data + pos, needle.data(), k) == 0) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    // Скалярный хвост (или весь поиск без SIMD): memchr по первому символу
+    while (i <= last) {
+        const char* hit = (const char*)memchr(data + i, needle[0], last - i + 1);
+        if (hit == nullptr) {
+            return string::npos;
+        }
+        i = hit - data;
+        if (memcmp(data + i, needle.data(), k) == 0) {
+            return i;
+        }
+        ++i;
+    }
+    return string::npos;
+}
+
+// Набор инструкций, которым выполняется findLiteral
+const char* literalSearchName() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "скалярный";
+#endif
+}
+
+// Скомпилированный шаблон: '*' и '?' разбираются один раз при создании,
+// сопоставление использует O(1) дополнительной памяти
+struct WildcardPattern {
+    string pattern; // Шаблон, в котором серии '*' схлопнуты в одну звездочку
+
+    // Предфильтр: литеральные части шаблона, которые обязаны встретиться в строке
+    struct Piece {
+        string text;  // Литерал без '?'
+        size_t skip;  // Сколько '?' стоит перед ним в том же сегменте
+    };
+    bool hasStar = false;     // Есть ли в шаблоне '*'
+    string head;              // Сегмент до первой '*' (привязан к началу строки)
+    string tail;              // Сегмент после последней '*' (привязан к концу строки)
+    vector<Piece> pieces;     // Литералы средних сегментов по порядку
+    bool exactFilter = true;  // Предфильтр точен (в средних сегментах нет '?')
+
+    // Компиляция шаблона
+    WildcardPattern(const string& source) {
+        for (char c : source) {
+            if (c == '*' && !pattern.empty() && pattern.back() == '*') {
+                continue; // "**" эквивалентно "*"
+            }
+            pattern += c;
+        }
+
+        size_t firstStar = pattern.find('*');
+        if (firstStar == string::npos) {
+            head = pattern; // Без '*' строка целиком сравнивается с шаблоном
+            return;
+        }
+        hasStar = true;
+        size_t lastStar = pattern.rfind('*');
+        head = pattern.substr(0, firstStar);
+        tail = pattern.substr(lastStar + 1);
+        // Средние сегменты разбиваются по '?' на литералы
+        size_t skip = 0;
+        string run;
+        for (size_t i = firstStar + 1; i < lastStar; ++i) {
+            char c = pattern[i];
+            if (c == '*' || c == '?') {
+                if (!run.empty()) {
+                    pieces.push_back({run, skip});
+                    run.clear();
+                    skip = 0;
+                }
+                if (c == '?') {
+                    ++skip;
+                    exactFilter = false;
+                } else {
+                    skip = 0; // '?' перед '*' лишь удлиняют строку - проверка остается необходимой
+                }
+            } else {
+                run += c;
+            }
+        }
+        if (!run.empty()) {
+            pieces.push_back({run, skip});
+        }
+    }
+
+    // Сравнение привязанного сегмента с str начиная с from ('?' - любой символ)
+    static bool anchoredEquals(string_view str, size_t from, const string& segment) {
+        for (size_t i = 0; i < segment.size(); ++i) {
+            if (segment[i] != '?' && segment[i] != str[from + i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Быстрая проверка: false означает, что строка точно не подходит.
+    // Начало и конец сравниваются напрямую, средние литералы ищутся по порядку.
+    bool mayMatch(string_view str) const {
+        size_t n = str.size();
+        if (!hasStar) {
+            return n == head.size() && anchoredEquals(str, 0, head);
+        }
+        if (n < head.size() + tail.size() || !anchoredEquals(str, 0, head) ||
+            !anchoredEquals(str, n - tail.size(), tail)) {
+            return false;
+        }
+        size_t pos = head.size();
+        size_t end = n - tail.size();
+        for (const Piece& piece : pieces) {
+            size_t found = findLiteral(str, pos + piece.skip, end, piece.text);
+            if (found == string::npos) {
+                return false;
+            }
+            pos = found + piece.text.size();
+        }
+        return true;
+    }
+
+    // Сопоставление с предфильтром: полный алгоритм запускается только для строк,
+    // прошедших фильтр, и только если фильтр неточен
+    bool matchesFiltered(string_view str) const {
+        if (!mayMatch(str)) {
+            return false;
+        }
+        return exactFilter || matches(str);
+    }
+
+    // Сопоставление жадным алгоритмом с возвратом к последней '*':
+    // '*' сначала захватывает пустую строку, при несовпадении захватывает на символ больше.
+    // Возвращаться дальше последней '*' не нужно: она может поглотить все, что поглотили бы прежние.
+    bool matches(string_view str) const {
+        size_t s = 0, p = 0;
+        size_t n = str.size(), m = pattern.size();
+        size_t starP = string::npos; // Позиция последней '*' в шаблоне
+        size_t starS = 0;            // Позиция строки, с которой она начала захват
+        while (s < n) {
+            if (p < m && (pattern[p] == '?' || pattern[p] == str[s])) {
+                ++s; // Символ совпал
+                ++p;
+            } else if (p < m && pattern[p] == '*') {
+                starP = p++; // Запоминаем '*', пока она захватывает пустую строку
+                starS = s;
+            } else if (starP != string::npos) {
+                p = starP + 1; // '*' захватывает еще один символ
+                s = ++starS;
+            } else {
+                return false;
+            }
+        }
+        while (p < m && pattern[p] == '*') {
+            ++p; // Завершающие '*' соответствуют пустой строке
+        }
+        return p == m;
+    }
+};
+
+// Набор шаблонов, объединенных в один автомат. Шаблоны складываются в префиксное
+// дерево по символам (общие начала хранятся один раз), узлы дерева - состояния НКА.
+// ДКА над множествами узлов строится лениво: переход вычисляется при первой встрече
+// и кэшируется. Кэш ограничен по памяти; при переполнении он очищается целиком,
+// и построение продолжается с текущего состояния.
+struct GlobSet {
+    // Узел дерева шаблонов
+    struct TrieNode {
+        vector<pair<char, uint32_t>> literals; // Переходы по обычным символам (по возрастанию)
+        int32_t any = -1;                      // Переход по '?'
+        int32_t star = -1;                     // Переход по '*'
+        bool isStar = false;                   // В узел ведет '*': он поглощает любые символы
+        vector<uint32_t> accepts;              // Шаблоны, заканчивающиеся в этом узле
+    };
+
+    // Состояние ДКА: множество узлов и переходы по всем байтам
+    struct DState {
+        vector<uint32_t> nodes;   // Узлы по возрастанию
+        vector<uint32_t> accepts; // Шаблоны, которым соответствует прочитанная строка
+        int32_t next[256];        // Переходы (-1 - еще не вычислен)
+    };
+
+    vector<TrieNode> trie;       // trie[0] - корень
+    size_t patternCount = 0;
+    size_t maxCacheBytes;        // Ограничение памяти кэша состояний
+    size_t cacheBytes = 0;       // Текущий объем кэша
+    size_t flushes = 0;          // Сколько раз кэш очищался
+    vector<DState> states;
+    unordered_map<string, int32_t> index; // Множество узлов (как байты) -> состояние
+    int32_t start = -1;                   // Начальное состояние (-1 - не построено)
+    vector<uint32_t> mark;                // Метки посещения при построении множеств
+    uint32_t generation = 0;
+    vector<uint32_t> scratch;             // Буфер построения множества
+
+    GlobSet(size_t cacheLimit = 64 << 20) : trie(1), maxCacheBytes(cacheLimit) {}
+
+    // Добавление шаблона; возвращает его номер
+    uint32_t add(const string& pattern) {
+        WildcardPattern compiled(pattern); // Схлопывает серии '*'
+        uint32_t node = 0;
+        for (char c : compiled.pattern) {
+            int32_t child;
+            if (c == '*' || c == '?') {
+                child = c == '*' ? trie[node].star : trie[node].any;
+                if (child < 0) {
+                    child = (int32_t)trie.size();
+                    (c == '*' ? trie[node].star : trie[node].any) = child;
+                    trie.emplace_back();
+                    trie.back().isStar = c == '*';
+                }
+            } else {
+                auto& literals = trie[node].literals;
+                auto it = lower_bound(literals.begin(), literals.end(), make_pair(c, (uint32_t)0));
+                if (it != literals.end() && it->first == c) {
+                    child = (int32_t)it->second;
+                } else {
+                    child = (int32_t)trie.size();
+                    literals.insert(it, make_pair(c, (uint32_t)child));
+                    trie.emplace_back();
+                }
+            }
+            node = (uint32_t)child;
+        }
+        uint32_t id = (uint32_t)patternCount++;
+        trie[node].accepts.push_back(id);
+        flushCache(); // Автомат изменился: кэш недействителен
+        flushes = 0;
+        return id;
+    }
+
+    // Добавление узла с замыканием по '*' (звездочка может захватить пустую строку)
+    void addClosure(int32_t node) {
+        while (node >= 0 && mark[node] != generation) {
+            mark[node] = generation;
+            scratch.push_back((uint32_t)node);
+            node = trie[node].star;
+        }
+    }
+
+    // Регистрация множества scratch как состояния ДКА; -1, если кэш переполнен
+    int32_t intern() {
+        sort(scratch.begin(), scratch.end());
+        string key((const char*)scratch.data(), scratch.size() * sizeof(uint32_t));
+        auto found = index.find(key);
+        if (found != index.end()) {
+            return found->second;
+        }
+        size_t bytes = sizeof(DState) + key.size() * 2 + 64;
+        if (cacheBytes + bytes > maxCacheBytes && !states.empty()) {
+            return -1;
+        }
+        DState state;
+        state.nodes = scratch;
+        for (uint32_t node : scratch) {
+            state.accepts.insert(state.accepts.end(), trie[node].accepts.begin(), trie[node].accepts.end());
+        }
+        sort(state.accepts.begin(), state.accepts.end());
+        fill(begin(state.next), end(state.next), -1);
+        states.push_back(move(state));
+        index.emplace(move(key), (int32_t)states.size() - 1);
+        cacheBytes += bytes;
+        return (int32_t)states.size() - 1;
+    }
+
+    // Регистрация множества с очисткой кэша при переполнении
+    int32_t internOrFlush() {
+        int32_t id = intern();
+        if (id < 0) {
+            vector<uint32_t> target = scratch;
+            flushCache();
+            scratch = move(target);
+            id = intern();
+        }
+        return id;
+    }
+
+    void flushCache() {
+        states.clear();
+        index.clear();
+        cacheBytes = 0;
+        start = -1;
+        ++flushes;
+    }
+
+    // Начальное состояние
+    int32_t startState() {
+        if (start < 0) {
+            mark.resize(trie.size(), 0);
+            ++generation;
+            scratch.clear();
+            addClosure(0);
+            start = internOrFlush();
+        }
+        return start;
+    }
+
+    // Вычисление перехода из состояния from по байту c
+    int32_t computeTransition(int32_t from, unsigned char c) {
+        ++generation;
+        scratch.clear();
+        for (uint32_t node : states[from].nodes) {
+            const TrieNode& current = trie[node];
+            if (current.isStar) {
+                addClosure((int32_t)node); // '*' поглощает символ
+            }
+            if (current.any >= 0) {
+                addClosure(current.any); // '?' - любой символ
+            }
+            auto it = lower_bound(current.literals.begin(), current.literals.end(), make_pair((char)c, (uint32_t)0));
+            if (it != current.literals.end() && it->first == (char)c) {
+                addClosure((int32_t)it->second);
+            }
+        }
+        size_t before = flushes;
+        int32_t to = internOrFlush();
+        if (flushes == before) {
+            states[from].next[c] = to; // Исходное состояние еще в кэше
+        }
+        return to;
+    }
+
+    // Номера всех шаблонов, которым соответствует строка (один проход по строке)
+    void match(string_view str, vector<uint32_t>& ids) {
+        ids.clear();
+        int32_t state = startState();
+        for (unsigned char c : str) {
+            int32_t next = states[state].next[c];
+            state = next >= 0 ? next : computeTransition(state, c);
+            if (states[state].nodes.empty()) {
+                return; // Ни один шаблон уже не может совпасть
+            }
+        }
+        ids = states[state].accepts;
+    }
+
+    // Сопоставление пачки строк; results[i] - номера шаблонов для строки i
+    void matchBatch(const Array& batch, vector<vector<uint32_t>>& results) {
+        results.resize(batch.size);
+        for (int i = 0; i < batch.size; ++i) {
+            match(batch.data[i], results[i]);
+        }
+    }
+};
+
+// Фильтрация большого файла по шаблону. Файл отображается в память, делится на блоки
+// по границам строк, блоки обрабатываются пулом потоков, а строки сопоставляются прямо
+// в отображенной памяти (string_view, без копирования). Совпавшие строки выводятся
+// в исходном порядке: в обработке одновременно не больше slotCount блоков.
+struct FileScanner {
+    static const size_t CHUNK = 4 << 20; // Номинальный размер блока (4 МБ)
+
+    // Блок файла и результат его обработки
+    struct Chunk {
+        vector<pair<size_t, size_t>> hits; // Совпавшие строки: начало и длина
+        size_t count = 0;                  // Количество совпавших строк
+        bool ready = false;                // Блок обработан
+    };
+
+    // Статистика рабочего потока
+    struct ThreadStats {
+        size_t chunks = 0;
+        size_t lines = 0;
+        double scanSeconds = 0;  // Поиск границ строк
+        double matchSeconds = 0; // Сопоставление с шаблоном
+    };
+
+    const char* data = nullptr;   // Отображенный файл
+    size_t size = 0;
+    const WildcardPattern& pattern;
+    bool countOnly;               // Выводить только количество совпадений
+    size_t slotCount;             // Количество блоков в обработке одновременно
+    vector<Chunk> slots;          // Кольцо результатов
+    size_t chunkTotal;            // Количество блоков в файле
+    size_t nextChunk = 0;         // Следующий блок для обработки
+    size_t written = 0;           // Количество выведенных блоков
+    vector<ThreadStats> stats;
+    mutex lock;
+    condition_variable batchReady; // Блок обработан
+    condition_variable slotFree;   // Блок выведен, слот свободен
+
+    FileScanner(const string& path, const WildcardPattern& p, bool onlyCount, int threads)
+        : pattern(p), countOnly(onlyCount), slotCount(threads * 4), slots(threads * 4), stats(threads) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("не удалось открыть файл " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw runtime_error("не удалось получить размер файла " + path);
+        }
+        size = info.st_size;
+        if (size > 0) {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("не удалось отобразить файл " + path);
+            }
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            data = (const char*)mapped;
+        }
+        close(fd);
+        chunkTotal = (size + CHUNK - 1) / CHUNK;
+    }
+
+    ~FileScanner() {
+        if (data != nullptr) {
+            munmap((void*)data, size);
+        }
+    }
+
+    // Начало блока index: первая строка, начинающаяся не раньше index * CHUNK.
+    // Оба соседних потока вычисляют одну и ту же границу, не договариваясь.
+    size_t chunkStart(size_t index) const {
+        if (index == 0) {
+            return 0;
+        }
+        size_t nominal = index * CHUNK;
+        if (nominal >= size) {
+            return size;
+        }
+        const char* newline = (const char*)memchr(data + nominal - 1, '\n', size - nominal + 1);
+        return newline == nullptr ? size : newline - data + 1;
+    }
+
+    // Обработка блока: сначала поиск границ строк, затем сопоставление
+    void processChunk(size_t index, Chunk& chunk, ThreadStats& stat, vector<size_t>& lineEnds) {
+        size_t begin = chunkStart(index);
+        size_t end = chunkStart(index + 1);
+        auto t0 = chrono::steady_clock::now();
+        lineEnds.clear();
+        for (size_t pos = begin; pos < end;) {
+            const char* newline = (const char*)memchr(data + pos, '\n', end - pos);
+            size_t lineEnd = newline == nullptr ? end : newline - data;
+            lineEnds.push_back(lineEnd);
+            pos = lineEnd + 1;
+        }
+        auto t1 = chrono::steady_clock::now();
+        chunk.hits.clear();
+        chunk.count = 0;
+        size_t pos = begin;
+        for (size_t lineEnd : lineEnds) {
+            string_view line(data + pos, lineEnd - pos);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (pattern.matchesFiltered(line)) {
+                ++chunk.count;
+                if (!countOnly) {
+                    chunk.hits.emplace_back(pos, line.size());
+                }
+            }
+            pos = lineEnd + 1;
+        }
+        auto t2 = chrono::steady_clock::now();
+        ++stat.chunks;
+        stat.lines += lineEnds.size();
+        stat.scanSeconds += chrono::duration<double>(t1 - t0).count();
+        stat.matchSeconds += chrono::duration<double>(t2 - t1).count();
+    }
+
+    // Рабочий поток: берет блоки по порядку, пока в кольце есть свободный слот
+    void worker(int id) {
+        vector<size_t> lineEnds; // Собственный буфер потока
+        while (true) {
+            size_t index;
+            {
+                unique_lock<mutex> guard(lock);
+                slotFree.wait(guard, [&] { return nextChunk >= chunkTotal || nextChunk - written < slotCount; });
+                if (nextChunk >= chunkTotal) {
+                    return;
+                }
+                index = nextChunk++;
+            }
+            Chunk& chunk = slots[index % slotCount];
+            processChunk(index, chunk, stats[id], lineEnds);
+            {
+                lock_guard<mutex> guard(lock);
+                chunk.ready = true;
+            }
+            batchReady.notify_all();
+        }
+    }
+
+    // Обработка файла: совпавшие строки (или их количество) выводятся в out по порядку
+    size_t run(FILE* out) {
+        vector<thread> pool;
+        for (size_t i = 0; i < stats.size(); ++i) {
+            pool.emplace_back(&FileScanner::worker, this, (int)i);
+        }
+        size_t total = 0;
+        for (size_t index = 0; index < chunkTotal; ++index) {
+            Chunk& chunk = slots[index % slotCount];
+            {
+                unique_lock<mutex> guard(lock);
+                batchReady.wait(guard, [&] { return chunk.ready; });
+            }
+            for (auto& hit : chunk.hits) {
+                fwrite(data + hit.first, 1, hit.second, out);
+                fputc('\n', out);
+            }
+            total += chunk.count;
+            {
+                lock_guard<mutex> guard(lock);
+                chunk.ready = false;
+                ++written;
+            }
+            slotFree.notify_all();
+        }
+        for (thread& t : pool) {
+            t.join();
+        }
+        return total;
+    }
+
+    // Статистика потоков: время поиска границ строк и сопоставления
+    void printStats(double seconds) const {
+        for (size_t i = 0; i < stats.size(); ++i) {
+            const ThreadStats& stat = stats[i];
+            cerr << "Поток " << i << ": блоков " << stat.chunks << ", строк " << stat.lines << ", поиск строк "
+                 << stat.scanSeconds * 1000 << " мс, сопоставление " << stat.matchSeconds * 1000 << " мс" << endl;
+        }
+        cerr << "Файл " << size / 1e6 << " МБ за " << seconds * 1000 << " мс: " << size / seconds / 1e9 << " ГБ/с" << endl;
+    }
+};
+
+// Случайная строка из алфавита alphabet
+string randomString(unsigned& seed, size_t length, const char* alphabet, size_t alphabetSize) {
+    string result(length, ' ');
+    for (char& c : result) {
+        seed = seed * 1103515245u + 12345u;
+        c = alphabet[(seed >> 16) % alphabetSize];
+    }
+    return result;
+}
+
+// Проверка на случайных данных: WildcardPattern (с предфильтром и без) должен совпадать с matches на каждой паре
+void runDifferentialTest(int cases) {
+    unsigned seed = 2024;
+    int mismatches = 0;
+    for (int i = 0; i < cases; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        string str = randomString(seed, (seed >> 16) % 12, "ab", 2);
+        seed = seed * 1103515245u + 12345u;
+        string pattern = randomString(seed, (seed >> 16) % 8, "ab*?", 4);
+        WildcardPattern compiled(pattern);
+        bool expected = matches(str, pattern);
+        if (expected != compiled.matches(str) || expected != compiled.matchesFiltered(str)) {
+            if (++mismatches <= 5) {
+                cerr << "Расхождение: \"" << str << "\" и \"" << pattern << "\"" << endl;
+            }
+        }
+    }
+    cout << "Случайных проверок: " << cases << ", расхождений: " << mismatches << endl;
+}
+
+// Время выполнения func в секундах
+template <typename Func>
+double measureSeconds(Func func) {
+    auto begin = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+// Бенчмарк пропускной способности: матрица DP против скомпилированного шаблона
+void runBenchmark() {
+    runDifferentialTest(200000);
+
+    unsigned seed = 7;
+    const size_t lineCount = 2000;
+    vector<string> lines;
+    for (size_t i = 0; i < lineCount; ++i) {
+        lines.push_back(randomString(seed, 2000, "abcdefgh", 8));
+    }
+    const string patterns[] = {"*abc*def*", "a?c*", "*h?h*g*a", string(100, '?') + "*"};
+    size_t bytes = lineCount * 2000;
+    for (const string& pattern : patterns) {
+        size_t dpHits = 0, compiledHits = 0;
+        double dpSeconds = measureSeconds([&] {
+            for (const string& line : lines) dpHits += matches(line, pattern);
+        });
+        WildcardPattern compiled(pattern);
+        double compiledSeconds = measureSeconds([&] {
+            for (const string& line : lines) compiledHits += compiled.matches(line);
+        });
+        cout << "\"" << pattern.substr(0, 20) << (pattern.size() > 20 ? "...\"" : "\"") << ": DP "
+             << bytes / dpSeconds / 1e6 << " МБ/с, скомпилированный " << bytes / compiledSeconds / 1e6
+             << " МБ/с" << (dpHits == compiledHits ? "" : " (РЕЗУЛЬТАТЫ РАЗЛИЧАЮТСЯ)") << endl;
+    }
+
+    // Строка 1 МБ и шаблон 1 КБ: матрице DP понадобился бы гигабайт памяти
+    string big = randomString(seed, 1 << 20, "abcdefgh", 8);
+    string bigPattern = "*" + big.substr(500000, 1022) + "*";
+    WildcardPattern compiled(bigPattern);
+    bool found = false;
+    double seconds = measureSeconds([&] { found = compiled.matches(big); });
+    cout << "Строка 1 МБ, шаблон 1 КБ: " << (found ? "совпадает" : "не совпадает") << ", " << seconds * 1000 << " мс" << endl;
+}
+
+// Бенчмарк предфильтра на строках в стиле журнала приложения: доля строк,
+// отброшенных без полного сопоставления, и итоговое ускорение
+void runPrefilterBenchmark() {
+    unsigned seed = 314;
+    const char* levels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+    const char* components[] = {"db", "http", "auth", "cache", "payment"};
+    const char* messages[] = {"request completed", "connection timeout after retry", "cache miss for key",
+                              "card declined by issuer", "session refreshed", "slow query detected"};
+    vector<string> lines;
+    size_t bytes = 0;
+    for (int i = 0; i < 200000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned r = seed >> 8;
+        string line = "2024-05-17 12:" + to_string(10 + r % 50) + ":" + to_string(10 + (r >> 6) % 50) + " " +
+                      levels[(r >> 12) % 6] + " [" + components[(r >> 15) % 5] + "] " + messages[(r >> 18) % 6] +
+                      " user=" + to_string((r >> 3) % 10000) + " latency=" + to_string(r % 1000) + "ms";
+        bytes += line.size();
+        lines.push_back(move(line));
+    }
+
+    cout << "Предфильтр (" << literalSearchName() << ", " << lines.size() << " строк):" << endl;
+    const string patterns[] = {"*ERROR*timeout*", "*user=4242 *", "2024-05-17 12:1?:*WARN*",
+                               "*[payment]*declined*latency=???ms", "*slow query*user=1??? *"};
+    double plainTotal = 0, filteredTotal = 0;
+    for (const string& text : patterns) {
+        WildcardPattern pattern(text);
+        size_t plainHits = 0, filteredHits = 0, rejected = 0;
+        double plainSeconds = measureSeconds([&] {
+            for (const string& line : lines) plainHits += pattern.matches(line);
+        });
+        double filteredSeconds = measureSeconds([&] {
+            for (const string& line : lines) filteredHits += pattern.matchesFiltered(line);
+        });
+        for (const string& line : lines) rejected += !pattern.mayMatch(line);
+        plainTotal += plainSeconds;
+        filteredTotal += filteredSeconds;
+        cout << "  \"" << text << "\": отброшено " << 100.0 * rejected / lines.size() << "%, без фильтра "
+             << bytes / plainSeconds / 1e6 << " МБ/с, с фильтром " << bytes / filteredSeconds / 1e6
+             << " МБ/с, ускорение " << plainSeconds / filteredSeconds << "x"
+             << (plainHits == filteredHits ? "" : " (РЕЗУЛЬТАТЫ РАЗЛИЧАЮТСЯ)") << endl;
+    }
+    cout << "  Всего ускорение " << plainTotal / filteredTotal << "x" << endl;
+}
+
+// Бенчмарк набора шаблонов: скорость просмотра строк при 10, 1000 и 100000 шаблонах
+void runGlobSetBenchmark() {
+    unsigned seed = 99;
+    const char* methods[] = {"GET", "POST", "PUT", "DELETE"};
+    // Строки в стиле журнала веб-сервера
+    Array batch(20000);
+    size_t bytes = 0;
+    for (int i = 0; i < batch.size; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        batch.data[i] = string(methods[(seed >> 8) % 4]) + " /api/v" + to_string((seed >> 12) % 3) + "/item/" +
+                        to_string((seed >> 4) % 100000) + " status=" + to_string(200 + (seed >> 20) % 4 * 100);
+        bytes += batch.data[i].size();
+    }
+
+    for (size_t count : {(size_t)10, (size_t)1000, (size_t)100000}) {
+        GlobSet set;
+        vector<WildcardPattern> separate;
+        for (size_t i = 0; i < count; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            string pattern;
+            switch (i % 3) {
+                case 0: pattern = "*/item/" + to_string((seed >> 4) % 100000) + " *"; break;
+                case 1: pattern = string(methods[(seed >> 8) % 4]) + " /api/v" + to_string((seed >> 12) % 3) + "/*=?00"; break;
+                default: pattern = "* status=" + to_string(200 + (seed >> 20) % 4 * 100); break;
+            }
+            set.add(pattern);
+            separate.emplace_back(pattern);
+        }
+
+        vector<vector<uint32_t>> results;
+        double setSeconds = measureSeconds([&] { set.matchBatch(batch, results); });
+        size_t total = 0;
+        for (auto& ids : results) total += ids.size();
+
+        // Проверка по шаблонам по отдельности на части строк
+        int checkLines = count > 1000 ? 20 : 2000;
+        size_t separateTotal = 0, setPart = 0;
+        double separateSeconds = measureSeconds([&] {
+            for (int i = 0; i < checkLines; ++i)
+                for (auto& pattern : separate) separateTotal += pattern.matches(batch.data[i]);
+        });
+        for (int i = 0; i < checkLines; ++i) setPart += results[i].size();
+        size_t checkBytes = 0;
+        for (int i = 0; i < checkLines; ++i) checkBytes += batch.data[i].size();
+
+        cout << count << " шаблонов: автомат " << bytes / setSeconds / 1e6 << " МБ/с (состояний "
+             << set.states.size() << ", очисток кэша " << set.flushes << ", совпадений " << total
+             << "), по одному шаблону " << checkBytes / separateSeconds / 1e6 << " МБ/с"
+             << (separateTotal == setPart ? "" : " (РЕЗУЛЬТАТЫ РАЗЛИЧАЮТСЯ)") << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runBenchmark(); // Режим замера производительности
+        runPrefilterBenchmark();
+        runGlobSetBenchmark();
+        return 0;
+    }
+
+    // Фильтрация файла: --scan <файл> <шаблон> [потоков] [--count]
+    if (argc > 3 && string(argv[1]) == "--scan") {
+        int threads = thread::hardware_concurrency();
+        bool countOnly = false;
+        for (int i = 4; i < argc; ++i) {
+            if (string(argv[i]) == "--count") {
+                countOnly = true;
+            } else {
+                threads = atoi(argv[i]);
+            }
+        }
+        if (threads < 1) {
+            threads = 1;
+        }
+        try {
+            WildcardPattern compiled(argv[3]);
+            FileScanner scanner(argv[2], compiled, countOnly, threads);
+            static char outputBuffer[1 << 20];
+            setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+            size_t total = 0;
+            double seconds = measureSeconds([&] { total = scanner.run(stdout); });
+            if (countOnly) {
+                printf("%zu\n", total);
+            }
+            fflush(stdout);
+            scanner.printStats(seconds);
+        } catch (const runtime_error& e) {
+            cerr << "Ошибка: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    string input; // Переменная для хранения строки на проверку
+    string pattern; // Переменная для хранения шаблона
+
+    // Запрашиваем у пользователя строку для проверки
+    cout << "Введите строку для проверки: ";
+    getline(cin, input); // Считываем строку с пробелами
+
+    // Запрашиваем у пользователя шаблон
+    cout << "Введите шаблон (используйте '*' для любой последовательности и '?' для одного символа): ";
+    getline(cin, pattern); // Считываем шаблон с пробелами
+
+    // Проверяем соответствие введенной строки с шаблоном
+    if (WildcardPattern(pattern).matchesFiltered(input)) {
+        // Если строка соответствует шаблону, выводим соответствующее сообщение
+        cout << "\"" << input << "\" соответствует шаблону \"" << pattern << "\"" << endl;
+    } else {
+        // Если строка не соответствует шаблону, выводим соответствующее сообщение
+        cout << "\"" << input << "\" не соответствует шаблону \"" << pattern << "\"" << endl;
+    }
+
+    return 0; // Завершение программы
+}
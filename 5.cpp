@@ -1,136 +1,1685 @@
-#include <iostream>
-#include <algorithm>
-
-using namespace std;
-
-// Структура узла AVL-дерева
-struct AVLNode {
-    int data = 0; // Значение узла
-    AVLNode* left = nullptr; // Указатель на левое поддерево
-    AVLNode* right = nullptr; // Указатель на правое поддерево
-    int balance = 0; // Разница высоты между левым и правым поддеревьями
-};
-
-// Функция для вычисления высоты узла
-int HeightAVL(AVLNode* root) {
-    if (root == nullptr) {
-        return 0; // Высота пустого узла равна 0
-    }
-    // Возвращаем максимальную высоту между левым и правым поддеревом + 1 (для текущего узла)
-    return max(HeightAVL(root->left), HeightAVL(root->right)) + 1;
-}
-
-// Функция для установки баланса узла
-void bfactor(AVLNode* root) {
-    if (root != nullptr) {
-        // Вычисляем баланс узла как разницу высот левого и правого поддеревьев
-        root->balance = HeightAVL(root->left) - HeightAVL(root->right);
-    }
-}
-
-// Функция для вращения вправо
-AVLNode* RotateRight(AVLNode* root) {
-    AVLNode* newRoot = root->left; // Новый корень будет левым дочерним узлом
-    root->left = newRoot->right; // Правое поддерево нового корня становится левым дочерним узлом старого корня
-    newRoot->right = root; // Старый корень становится правым дочерним узлом нового корня
-    bfactor(root); // Пересчитываем баланс старого корня
-    bfactor(newRoot); // Пересчитываем баланс нового корня
-    return newRoot; // Возвращаем новый корень
-}
-
-// Функция для вращения влево
-AVLNode* RotateLeft(AVLNode* root) {
-    AVLNode* newRoot = root->right; // Новый корень будет правым дочерним узлом
-    root->right = newRoot->left; // Левое поддерево нового корня становится правым дочерним узлом старого корня
-    newRoot->left = root; // Старый корень становится левым дочерним узлом нового корня
-    bfactor(root); // Пересчитываем баланс старого корня
-    bfactor(newRoot); // Пересчитываем баланс нового корня
-    return newRoot; // Возвращаем новый корень
-}
-
-// Функция для вставки узла без балансировки
-AVLNode* Insert(AVLNode* root, int value) {
-    if (root == nullptr) {
-        return new AVLNode{value}; // Создаем новый узел, если дерево пустое
-    }
-    if (value < root->data) {
-        root->left = Insert(root->left, value); // Рекурсивно вставляем в левое поддерево
-    } else if (value > root->data) {
-        root->right = Insert(root->right, value); // Рекурсивно вставляем в правое поддерево
-    }
-    return root; // Возвращаем корень без балансировки
-}
-
-// Функция для балансировки узла
-AVLNode* BalanceAVL(AVLNode* root) {
-    bfactor(root); // Обновляем баланс узла
-
-    // Проверка баланса и выполнение вращений
-    if (root->balance > 1) {
-        if (root->left->balance < 0) {
-            root->left = RotateLeft(root->left); // Левый правый случай
-        }
-        return RotateRight(root); // Левый левый случай
-    }
-    
-    if (root->balance < -1) {
-        if (root->right->balance > 0) {
-            root->right = RotateRight(root->right); // Правый левый случай
-        }
-        return RotateLeft(root); // Правый правый случай
-    }
-
-    return root; // Возвращаем (возможно) сбалансированный корень
-}
-
-// Функция для полной балансировки дерева
-AVLNode* BalanceTree(AVLNode* root) {
-    if (root == nullptr) return nullptr; // Если дерево пустое, возвращаем nullptr
-
-    root->left = BalanceTree(root->left);   // Балансируем левое поддерево
-    root->right = BalanceTree(root->right); // Балансируем правое поддерево
-    return BalanceAVL(root);                // Балансируем текущий узел
-}
-
-// Функция для проверки сбалансированности дерева
-bool IsBalanced(AVLNode* root) {
-    if (root == nullptr) return true; // Пустое дерево считается сбалансированным
-
-    int leftHeight = HeightAVL(root->left); // Высота левого поддерева
-    int rightHeight = HeightAVL(root->right); // Высота правого поддерева
-
-    // Проверяем, что разница высот не превышает 1 и рекурсивно проверяем поддеревья
-    return (abs(leftHeight - rightHeight) <= 1) &&
-            IsBalanced(root->left) &&
-            IsBalanced(root->right);
-}
-
-int main() {
-    system("chcp 65001"); // Устанавливаем кодировку консоли на UTF-8
-    AVLNode* root = nullptr; // Инициализируем корень дерева как nullptr
-    int value;
-
-    cout << "Введите числа (нечисло для завершения): "; // Запрос ввода чисел
-    while (cin >> value) {
-        root = Insert(root, value); // Вставляем узлы без балансировки
-    }
-
-    // Проверка сбалансированности изначального дерева
-    if (IsBalanced(root)) {
-        cout << "дерево сбалансировано." << endl;
-    } else {
-        cout << "дерево не сбалансировано." << endl;
-    }
-
-    // Балансировка всего дерева
-    root = BalanceTree(root);
-
-    // Проверка сбалансированности после балансировки
-    if (IsBalanced(root)) {
-        cout << "После балансировки дерево сбалансировано." << endl;
-    } else {
-        cout << "После балансировки дерево несбалансировано." << endl;
-    }
-
-    return 0; // Завершение программы
-}
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <set>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+
+// Структура узла AVL-дерева
+struct AVLNode {
+    int data = 0; // Значение узла
+    AVLNode* left = nullptr; // Указатель на левое поддерево
+    AVLNode* right = nullptr; // Указатель на правое поддерево
+    int balance = 0; // Разница высоты между левым и правым поддеревьями
+    int height = 1; // Высота поддерева (поддерживается только в AVLTree)
+    int size = 1; // Количество узлов в поддереве (поддерживается только в AVLTree)
+};
+
+// Функция для вычисления высоты узла
+int HeightAVL(AVLNode* root) {
+    if (root == nullptr) {
+        return 0; // Высота пустого узла равна 0
+    }
+    // Возвращаем максимальную высоту между левым и правым поддеревом + 1 (для текущего узла)
+    return max(HeightAVL(root->left), HeightAVL(root->right)) + 1;
+}
+
+// Функция для установки баланса узла
+void bfactor(AVLNode* root) {
+    if (root != nullptr) {
+        // Вычисляем баланс узла как разницу высот левого и правого поддеревьев
+        root->balance = HeightAVL(root->left) - HeightAVL(root->right);
+    }
+}
+
+// Функция для вращения вправо
+AVLNode* RotateRight(AVLNode* root) {
+    AVLNode* newRoot = root->left; // Новый корень будет левым дочерним узлом
+    root->left = newRoot->right; // Правое поддерево нового корня становится левым дочерним узлом старого корня
+    newRoot->right = root; // Старый корень становится правым дочерним узлом нового корня
+    bfactor(root); // Пересчитываем баланс старого корня
+    bfactor(newRoot); // Пересчитываем баланс нового корня
+    return newRoot; // Возвращаем новый корень
+}
+
+// Функция для вращения влево
+AVLNode* RotateLeft(AVLNode* root) {
+    AVLNode* newRoot = root->right; // Новый корень будет правым дочерним узлом
+    root->right = newRoot->left; // Левое поддерево нового корня становится правым дочерним узлом старого корня
+    newRoot->left = root; // Старый корень становится левым дочерним узлом нового корня
+    bfactor(root); // Пересчитываем баланс старого корня
+    bfactor(newRoot); // Пересчитываем баланс нового корня
+    return newRoot; // Возвращаем новый корень
+}
+
+// Функция для вставки узла без балансировки
+AVLNode* Insert(AVLNode* root, int value) {
+    if (root == nullptr) {
+        return new AVLNode{value}; // Создаем новый узел, если дерево пустое
+    }
+    if (value < root->data) {
+        root->left = Insert(root->left, value); // Рекурсивно вставляем в левое поддерево
+    } else if (value > root->data) {
+        root->right = Insert(root->right, value); // Рекурсивно вставляем в правое поддерево
+    }
+    return root; // Возвращаем корень без балансировки
+}
+
+// Функция для балансировки узла
+AVLNode* BalanceAVL(AVLNode* root) {
+    bfactor(root); // Обновляем баланс узла
+
+    // Проверка баланса и выполнение вращений
+    if (root->balance > 1) {
+        if (root->left->balance < 0) {
+            root->left = RotateLeft(root->left); // Левый правый случай
+        }
+        return RotateRight(root); // Левый левый случай
+    }
+    
+    if (root->balance < -1) {
+        if (root->right->balance > 0) {
+            root->right = RotateRight(root->right); // Правый левый случай
+        }
+        return RotateLeft(root); // Правый правый случай
+    }
+
+    return root; // Возвращаем (возможно) сбалансированный корень
+}
+
+// Функция для полной балансировки дерева
+AVLNode* BalanceTree(AVLNode* root) {
+    if (root == nullptr) return nullptr; // Если дерево пустое, возвращаем nullptr
+
+    root->left = BalanceTree(root->left);   // Балансируем левое поддерево
+    root->right = BalanceTree(root->right); // Балансируем правое поддерево
+    return BalanceAVL(root);                // Балансируем текущий узел
+}
+
+// Результат проверки дерева
+struct TreeStats {
+    size_t nodes = 0;               // Количество узлов
+    int height = 0;                 // Высота дерева
+    bool ordered = true;            // Ключи упорядочены как в дереве поиска
+    bool balanced = true;           // Выполнено AVL-условие по фактическим высотам
+    size_t storedMismatches = 0;    // Узлы с неверными сохраненными height/balance/size
+    int worstImbalance = 0;         // Наибольшая разница высот поддеревьев
+    int worstImbalanceKey = 0;      // Узел с наибольшей разницей
+    vector<size_t> depthHistogram;  // Количество узлов на каждой глубине
+
+    // Дерево - корректное AVL-дерево с верными сохраненными значениями
+    bool valid() const {
+        return ordered && balanced && storedMismatches == 0;
+    }
+};
+
+// Проверка дерева за один проход O(n) без рекурсии: порядок ключей, AVL-условие,
+// сохраненные высоты, балансы и размеры. Стек в куче, поэтому вырожденное дерево
+// любой глубины проверяется без переполнения стека вызовов.
+TreeStats ValidateTree(AVLNode* root) {
+    struct Frame {
+        AVLNode* node;
+        long long low, high; // Допустимые ключи: (low, high)
+        int depth;
+        int stage;           // 0 - узел не посещен, 1 - обходится левое поддерево, 2 - правое
+        int leftHeight;
+        int leftSize;
+    };
+    TreeStats stats;
+    vector<Frame> stack;
+    stack.push_back({root, INT64_MIN, INT64_MAX, 0, 0, 0, 0});
+    int returnedHeight = 0; // Высота и размер только что проверенного поддерева
+    int returnedSize = 0;
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        AVLNode* node = frame.node;
+        if (node == nullptr) {
+            returnedHeight = 0;
+            returnedSize = 0;
+            stack.pop_back();
+            continue;
+        }
+        if (frame.stage == 0) {
+            ++stats.nodes;
+            if ((size_t)frame.depth >= stats.depthHistogram.size()) {
+                stats.depthHistogram.resize(frame.depth + 1, 0);
+            }
+            ++stats.depthHistogram[frame.depth];
+            if (node->data <= frame.low || node->data >= frame.high) {
+                stats.ordered = false;
+            }
+            frame.stage = 1;
+            Frame child = {node->left, frame.low, node->data, frame.depth + 1, 0, 0, 0};
+            stack.push_back(child);
+        } else if (frame.stage == 1) {
+            frame.leftHeight = returnedHeight;
+            frame.leftSize = returnedSize;
+            frame.stage = 2;
+            Frame child = {node->right, node->data, frame.high, frame.depth + 1, 0, 0, 0};
+            stack.push_back(child);
+        } else {
+            int leftHeight = frame.leftHeight, rightHeight = returnedHeight;
+            int height = max(leftHeight, rightHeight) + 1;
+            int size = frame.leftSize + returnedSize + 1;
+            int imbalance = abs(leftHeight - rightHeight);
+            if (imbalance > 1) {
+                stats.balanced = false;
+            }
+            if (imbalance > stats.worstImbalance) {
+                stats.worstImbalance = imbalance;
+                stats.worstImbalanceKey = node->data;
+            }
+            if (node->height != height || node->balance != leftHeight - rightHeight || node->size != size) {
+                ++stats.storedMismatches;
+            }
+            returnedHeight = height;
+            returnedSize = size;
+            stack.pop_back();
+        }
+    }
+    stats.height = returnedHeight;
+    return stats;
+}
+
+// Результат проверки в формате JSON
+string TreeStatsJson(const TreeStats& stats) {
+    ostringstream out;
+    out << "{\"nodes\":" << stats.nodes << ",\"height\":" << stats.height << ",\"ordered\":"
+        << (stats.ordered ? "true" : "false") << ",\"balanced\":" << (stats.balanced ? "true" : "false")
+        << ",\"stored_mismatches\":" << stats.storedMismatches << ",\"worst_imbalance\":" << stats.worstImbalance
+        << ",\"worst_imbalance_key\":" << stats.worstImbalanceKey << ",\"depth_histogram\":[";
+    for (size_t i = 0; i < stats.depthHistogram.size(); ++i) {
+        out << (i > 0 ? "," : "") << stats.depthHistogram[i];
+    }
+    out << "]}";
+    return out.str();
+}
+
+// Функция для проверки сбалансированности дерева (один проход O(n), без рекурсии)
+bool IsBalanced(AVLNode* root) {
+    return ValidateTree(root).balanced;
+}
+
+// Освобождение всех узлов без рекурсии: левые поддеревья поворотами переносятся вправо
+void FreeTree(AVLNode* root) {
+    AVLNode* node = root;
+    while (node != nullptr) {
+        if (node->left != nullptr) {
+            AVLNode* left = node->left;
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            AVLNode* right = node->right;
+            delete node;
+            node = right;
+        }
+    }
+}
+
+// Размер поддерева по сохраненному значению
+int SubtreeSize(AVLNode* node) {
+    return node == nullptr ? 0 : node->size;
+}
+
+// Пересчет высоты, баланса и размера узла по сохраненным значениям детей
+void FixHeight(AVLNode* node) {
+    int leftHeight = node->left == nullptr ? 0 : node->left->height;
+    int rightHeight = node->right == nullptr ? 0 : node->right->height;
+    node->height = max(leftHeight, rightHeight) + 1;
+    node->balance = leftHeight - rightHeight;
+    node->size = SubtreeSize(node->left) + SubtreeSize(node->right) + 1;
+}
+
+// Построение идеально сбалансированного дерева из n узлов, выдаваемых next() по
+// возрастанию ключей, за O(n). Корень каждого поддерева - средний элемент его диапазона,
+// поэтому размеры поддеревьев отличаются не больше чем на 1. Рекурсия заменена стеком
+// диапазонов глубиной log2(n) + 1; attach(node, left, right) связывает узел с детьми
+// и заполняет высоту при закрытии поддерева. Handle - указатель или номер узла.
+template <typename Handle, typename Next, typename Attach>
+Handle BuildBalanced(size_t n, Handle empty, Next next, Attach attach) {
+    struct Frame {
+        size_t low, high; // Диапазон поддерева [low, high)
+        Handle node;      // Корень поддерева
+        Handle left;      // Готовое левое поддерево
+        bool open;        // Левое поддерево еще строится
+    };
+    Frame stack[64];
+    int top = 0;
+    Handle result = empty; // Последнее достроенное поддерево
+    // Спуск к самому левому пустому поддереву диапазона
+    auto descend = [&](size_t low, size_t high) {
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            stack[top++] = {low, high, empty, empty, true};
+            high = mid;
+        }
+        result = empty;
+    };
+    descend(0, n);
+    while (top > 0) {
+        Frame& frame = stack[top - 1];
+        if (frame.open) {
+            // Левое поддерево готово: следующий по порядку узел - корень диапазона
+            frame.open = false;
+            frame.node = next();
+            frame.left = result;
+            size_t mid = frame.low + (frame.high - frame.low) / 2;
+            descend(mid + 1, frame.high);
+        } else {
+            // Правое поддерево готово: диапазон закрыт
+            attach(frame.node, frame.left, result);
+            result = frame.node;
+            --top;
+        }
+    }
+    return result;
+}
+
+// Связывание узла с детьми при построении
+void AttachChildren(AVLNode* node, AVLNode* left, AVLNode* right) {
+    node->left = left;
+    node->right = right;
+    FixHeight(node);
+}
+
+// Количество различных ключей в отсортированном массиве
+size_t CountSortedUnique(const vector<int>& keys) {
+    size_t unique = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (i > 0 && keys[i] < keys[i - 1]) {
+            throw runtime_error("ключи не отсортированы");
+        }
+        unique += i == 0 || keys[i] != keys[i - 1];
+    }
+    return unique;
+}
+
+// Дерево из отсортированных ключей за O(n); повторяющиеся ключи пропускаются
+AVLNode* BuildFromSorted(const vector<int>& keys) {
+    size_t pos = 0;
+    return BuildBalanced(CountSortedUnique(keys), (AVLNode*)nullptr, [&] {
+        while (pos > 0 && pos < keys.size() && keys[pos] == keys[pos - 1]) {
+            ++pos;
+        }
+        return new AVLNode{keys[pos++]};
+    }, AttachChildren);
+}
+
+// Перестройка любого дерева поиска (в том числе вырожденного после Insert) за O(n):
+// поворотами вправо дерево вытягивается в список по возрастанию, затем список
+// собирается в сбалансированное дерево. Новых узлов и рекурсии нет.
+AVLNode* RebuildTree(AVLNode* root, size_t* nodeCount = nullptr) {
+    AVLNode head; // Фиктивный узел перед списком
+    head.right = root;
+    AVLNode* tail = &head;
+    size_t n = 0;
+    while (tail->right != nullptr) {
+        AVLNode* node = tail->right;
+        if (node->left != nullptr) {
+            // Левый ребенок поднимается на место узла
+            AVLNode* left = node->left;
+            node->left = left->right;
+            left->right = node;
+            tail->right = left;
+        } else {
+            tail = node; // Узел занял свое место в списке
+            ++n;
+        }
+    }
+    AVLNode* vine = head.right;
+    if (nodeCount != nullptr) {
+        *nodeCount = n;
+    }
+    return BuildBalanced(n, (AVLNode*)nullptr, [&] {
+        AVLNode* node = vine;
+        vine = vine->right;
+        return node;
+    }, AttachChildren);
+}
+
+// Самобалансирующееся AVL-дерево: высота хранится в узле, вставка и удаление
+// восстанавливают баланс только на пути от изменения к корню - O(log n).
+// Путь запоминается в массиве ссылок, поэтому рекурсии нет вовсе.
+struct AVLTree {
+    // Высота AVL-дерева из n узлов не больше 1.44 * log2(n + 2): 96 хватает для любого n
+    static const int MAX_DEPTH = 96;
+
+    // Счетчики операций над деревом
+    struct Counters {
+        size_t inserts = 0;
+        size_t erases = 0;
+        size_t rotationsLeft = 0;       // Малые левые вращения (правый правый случай)
+        size_t rotationsRight = 0;      // Малые правые вращения (левый левый случай)
+        size_t rotationsLeftRight = 0;  // Большие вращения в левом правом случае
+        size_t rotationsRightLeft = 0;  // Большие вращения в правом левом случае
+        size_t rebuilds = 0;            // Полные перестройки
+    };
+
+    AVLNode* root = nullptr; // Корень дерева
+    size_t count = 0;        // Количество ключей
+    Counters counters;
+
+    AVLTree() {}
+    AVLTree(const AVLTree&) = delete;
+    AVLTree& operator=(const AVLTree&) = delete;
+
+    ~AVLTree() {
+        clear();
+    }
+
+    // Высота поддерева по сохраненному значению
+    static int height(AVLNode* node) {
+        return node == nullptr ? 0 : node->height;
+    }
+
+    // Пересчет высоты и баланса узла по детям
+    static void fixHeight(AVLNode* node) {
+        FixHeight(node);
+    }
+
+    // Вращение вправо с пересчетом сохраненных высот
+    static AVLNode* rotateRight(AVLNode* node) {
+        AVLNode* newRoot = node->left;
+        node->left = newRoot->right;
+        newRoot->right = node;
+        fixHeight(node);
+        fixHeight(newRoot);
+        return newRoot;
+    }
+
+    // Вращение влево с пересчетом сохраненных высот
+    static AVLNode* rotateLeft(AVLNode* node) {
+        AVLNode* newRoot = node->right;
+        node->right = newRoot->left;
+        newRoot->left = node;
+        fixHeight(node);
+        fixHeight(newRoot);
+        return newRoot;
+    }
+
+    // Восстановление баланса узла, у которого поддеревья уже сбалансированы
+    AVLNode* rebalance(AVLNode* node) {
+        fixHeight(node);
+        if (node->balance > 1) {
+            if (node->left->balance < 0) {
+                node->left = rotateLeft(node->left); // Левый правый случай
+                ++counters.rotationsLeftRight;
+            } else {
+                ++counters.rotationsRight;
+            }
+            return rotateRight(node); // Левый левый случай
+        }
+        if (node->balance < -1) {
+            if (node->right->balance > 0) {
+                node->right = rotateRight(node->right); // Правый левый случай
+                ++counters.rotationsRightLeft;
+            } else {
+                ++counters.rotationsLeft;
+            }
+            return rotateLeft(node); // Правый правый случай
+        }
+        return node;
+    }
+
+    // Подъем по пути с балансировкой. Когда высота поддерева перестала меняться,
+    // выше по пути нужно только исправить размеры на delta (+1 при вставке, -1 при удалении)
+    void rebalancePath(AVLNode** path[], int depth, int delta) {
+        while (depth > 0) {
+            AVLNode** link = path[--depth];
+            int oldHeight = (*link)->height;
+            *link = rebalance(*link);
+            if ((*link)->height == oldHeight) {
+                break; // Высоты выше по пути не меняются
+            }
+        }
+        while (depth > 0) {
+            (*path[--depth])->size += delta;
+        }
+    }
+
+    // Вставка ключа; false, если он уже есть
+    bool insert(int value) {
+        AVLNode** path[MAX_DEPTH];
+        int depth = 0;
+        AVLNode** link = &root;
+        while (*link != nullptr) {
+            path[depth++] = link;
+            AVLNode* node = *link;
+            if (value < node->data) {
+                link = &node->left;
+            } else if (value > node->data) {
+                link = &node->right;
+            } else {
+                return false;
+            }
+        }
+        *link = new AVLNode{value};
+        ++count;
+        ++counters.inserts;
+        rebalancePath(path, depth, +1);
+        return true;
+    }
+
+    // Удаление ключа; false, если его нет
+    bool erase(int value) {
+        AVLNode** path[MAX_DEPTH];
+        int depth = 0;
+        AVLNode** link = &root;
+        while (*link != nullptr && (*link)->data != value) {
+            path[depth++] = link;
+            link = value < (*link)->data ? &(*link)->left : &(*link)->right;
+        }
+        AVLNode* node = *link;
+        if (node == nullptr) {
+            return false;
+        }
+        if (node->left != nullptr && node->right != nullptr) {
+            // Два ребенка: значение заменяется преемником, удаляется узел преемника
+            path[depth++] = link;
+            link = &node->right;
+            while ((*link)->left != nullptr) {
+                path[depth++] = link;
+                link = &(*link)->left;
+            }
+            node->data = (*link)->data;
+            node = *link;
+        }
+        *link = node->left != nullptr ? node->left : node->right;
+        delete node;
+        --count;
+        ++counters.erases;
+        rebalancePath(path, depth, -1);
+        return true;
+    }
+
+    // Поиск ключа
+    bool contains(int value) const {
+        AVLNode* node = root;
+        while (node != nullptr) {
+            if (value == node->data) {
+                return true;
+            }
+            node = value < node->data ? node->left : node->right;
+        }
+        return false;
+    }
+
+    // Количество ключей меньше value (или не больше value при inclusive) за O(log n)
+    size_t rank(int value, bool inclusive = false) const {
+        size_t result = 0;
+        AVLNode* node = root;
+        while (node != nullptr) {
+            if (node->data < value || (inclusive && node->data == value)) {
+                result += SubtreeSize(node->left) + 1; // Узел и все его левое поддерево меньше
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+        return result;
+    }
+
+    // k-й по возрастанию ключ (с нуля) за O(log n)
+    int select(size_t k) const {
+        if (k >= count) {
+            throw runtime_error("номер ключа вне дерева");
+        }
+        AVLNode* node = root;
+        while (true) {
+            size_t leftSize = SubtreeSize(node->left);
+            if (k < leftSize) {
+                node = node->left;
+            } else if (k == leftSize) {
+                return node->data;
+            } else {
+                k -= leftSize + 1;
+                node = node->right;
+            }
+        }
+    }
+
+    // Количество ключей в отрезке [low, high] за O(log n)
+    size_t countRange(int low, int high) const {
+        if (low > high) {
+            return 0;
+        }
+        return rank(high, true) - rank(low);
+    }
+
+    // Обход ключей отрезка [low, high] по возрастанию без выделения памяти:
+    // стек предков лежит в самом курсоре и не глубже высоты дерева
+    struct RangeCursor {
+        AVLNode* stack[MAX_DEPTH]; // Узлы, к которым осталось вернуться
+        int top = 0;
+        int high;                  // Правая граница отрезка
+
+        // Спуск к первому ключу не меньше low
+        RangeCursor(AVLNode* root, int low, int limit) : high(limit) {
+            AVLNode* node = root;
+            while (node != nullptr) {
+                if (node->data >= low) {
+                    stack[top++] = node;
+                    node = node->left;
+                } else {
+                    node = node->right;
+                }
+            }
+        }
+
+        // Следующий ключ отрезка; false, когда отрезок закончился
+        bool next(int& value) {
+            if (top == 0 || stack[top - 1]->data > high) {
+                top = 0;
+                return false;
+            }
+            AVLNode* node = stack[--top];
+            value = node->data;
+            for (node = node->right; node != nullptr; node = node->left) {
+                stack[top++] = node;
+            }
+            return true;
+        }
+    };
+
+    RangeCursor range(int low, int high) const {
+        return RangeCursor(root, low, high);
+    }
+
+    // Счетчики и результат проверки дерева в формате JSON (для мониторинга)
+    string statsJson() const {
+        ostringstream out;
+        out << "{\"keys\":" << count << ",\"inserts\":" << counters.inserts << ",\"erases\":" << counters.erases
+            << ",\"rotations\":{\"left\":" << counters.rotationsLeft << ",\"right\":" << counters.rotationsRight
+            << ",\"left_right\":" << counters.rotationsLeftRight << ",\"right_left\":" << counters.rotationsRightLeft
+            << "},\"rebuilds\":" << counters.rebuilds << ",\"tree\":" << TreeStatsJson(ValidateTree(root)) << "}";
+        return out.str();
+    }
+
+    // Загрузка отсортированных ключей за O(n) (прежнее содержимое удаляется)
+    void buildSorted(const vector<int>& keys) {
+        AVLNode* built = BuildFromSorted(keys);
+        clear();
+        root = built;
+        count = CountSortedUnique(keys);
+    }
+
+    // Загрузка произвольных ключей: сортировка и построение
+    void build(vector<int> keys) {
+        sort(keys.begin(), keys.end());
+        buildSorted(keys);
+    }
+
+    // Перестройка в идеально сбалансированное дерево за O(n)
+    void rebuild() {
+        root = RebuildTree(root, &count);
+        ++counters.rebuilds;
+    }
+
+    void clear() {
+        FreeTree(root);
+        root = nullptr;
+        count = 0;
+    }
+};
+
+// Узел в пуле: дети задаются 32-битными номерами, 0 - пустая ссылка (16 байт вместо 32)
+struct PoolNode {
+    int data;       // Значение узла
+    uint32_t left;  // Номер левого ребенка
+    uint32_t right; // Номер правого ребенка
+    int height;     // Высота поддерева
+};
+
+// Пул узлов: узлы лежат подряд в блоках по 2^20 штук, блоки никогда не перемещаются.
+// Освобожденные узлы связываются в список через left; все дерево удаляется сразу.
+struct NodePool {
+    static const int SLAB_BITS = 20;
+    static const uint32_t SLAB_SIZE = 1u << SLAB_BITS;
+
+    vector<unique_ptr<PoolNode[]>> slabs; // Блоки узлов
+    uint64_t used = 1;                    // Выдано номеров (номер 0 зарезервирован)
+    uint32_t freeList = 0;                // Голова списка освобожденных узлов
+
+    PoolNode& operator[](uint32_t index) {
+        return slabs[index >> SLAB_BITS][index & (SLAB_SIZE - 1)];
+    }
+    const PoolNode& operator[](uint32_t index) const {
+        return slabs[index >> SLAB_BITS][index & (SLAB_SIZE - 1)];
+    }
+
+    // Новый узел со значением value
+    uint32_t allocate(int value) {
+        uint32_t index;
+        if (freeList != 0) {
+            index = freeList;
+            freeList = (*this)[index].left;
+        } else {
+            if (used > UINT32_MAX) {
+                throw runtime_error("пул узлов переполнен");
+            }
+            index = (uint32_t)used++;
+            if ((index >> SLAB_BITS) >= slabs.size()) {
+                slabs.emplace_back(new PoolNode[SLAB_SIZE]);
+            }
+        }
+        (*this)[index] = {value, 0, 0, 1};
+        return index;
+    }
+
+    // Возврат узла в пул
+    void release(uint32_t index) {
+        (*this)[index].left = freeList;
+        freeList = index;
+    }
+
+    // Освобождение всех узлов сразу
+    void clear() {
+        slabs.clear();
+        used = 1;
+        freeList = 0;
+    }
+};
+
+// AVL-дерево на узлах из пула: те же алгоритмы, что в AVLTree, но ссылки - номера
+struct PooledAVLTree {
+    NodePool pool;
+    uint32_t root = 0;
+    size_t count = 0;
+
+    int height(uint32_t node) const {
+        return node == 0 ? 0 : pool[node].height;
+    }
+
+    int balance(uint32_t node) const {
+        return height(pool[node].left) - height(pool[node].right);
+    }
+
+    void fixHeight(uint32_t node) {
+        PoolNode& n = pool[node];
+        n.height = max(height(n.left), height(n.right)) + 1;
+    }
+
+    uint32_t rotateRight(uint32_t node) {
+        uint32_t newRoot = pool[node].left;
+        pool[node].left = pool[newRoot].right;
+        pool[newRoot].right = node;
+        fixHeight(node);
+        fixHeight(newRoot);
+        return newRoot;
+    }
+
+    uint32_t rotateLeft(uint32_t node) {
+        uint32_t newRoot = pool[node].right;
+        pool[node].right = pool[newRoot].left;
+        pool[newRoot].left = node;
+        fixHeight(node);
+        fixHeight(newRoot);
+        return newRoot;
+    }
+
+    uint32_t rebalance(uint32_t node) {
+        fixHeight(node);
+        int factor = balance(node);
+        if (factor > 1) {
+            if (balance(pool[node].left) < 0) {
+                pool[node].left = rotateLeft(pool[node].left); // Левый правый случай
+            }
+            return rotateRight(node); // Левый левый случай
+        }
+        if (factor < -1) {
+            if (balance(pool[node].right) > 0) {
+                pool[node].right = rotateRight(pool[node].right); // Правый левый случай
+            }
+            return rotateLeft(node); // Правый правый случай
+        }
+        return node;
+    }
+
+    // Подъем по пути с балансировкой (ссылки указывают в блоки пула, которые не перемещаются)
+    void rebalancePath(uint32_t* path[], int depth) {
+        while (depth > 0) {
+            uint32_t* link = path[--depth];
+            int oldHeight = pool[*link].height;
+            *link = rebalance(*link);
+            if (pool[*link].height == oldHeight) {
+                break;
+            }
+        }
+    }
+
+    // Вставка ключа; false, если он уже есть
+    bool insert(int value) {
+        uint32_t* path[AVLTree::MAX_DEPTH];
+        int depth = 0;
+        uint32_t* link = &root;
+        while (*link != 0) {
+            path[depth++] = link;
+            PoolNode& node = pool[*link];
+            if (value < node.data) {
+                link = &node.left;
+            } else if (value > node.data) {
+                link = &node.right;
+            } else {
+                return false;
+            }
+        }
+        uint32_t created = pool.allocate(value); // Выделение не перемещает блоки: link действителен
+        *link = created;
+        ++count;
+        rebalancePath(path, depth);
+        return true;
+    }
+
+    // Удаление ключа; false, если его нет
+    bool erase(int value) {
+        uint32_t* path[AVLTree::MAX_DEPTH];
+        int depth = 0;
+        uint32_t* link = &root;
+        while (*link != 0 && pool[*link].data != value) {
+            path[depth++] = link;
+            link = value < pool[*link].data ? &pool[*link].left : &pool[*link].right;
+        }
+        uint32_t node = *link;
+        if (node == 0) {
+            return false;
+        }
+        if (pool[node].left != 0 && pool[node].right != 0) {
+            // Два ребенка: значение заменяется преемником
+            path[depth++] = link;
+            link = &pool[node].right;
+            while (pool[*link].left != 0) {
+                path[depth++] = link;
+                link = &pool[*link].left;
+            }
+            pool[node].data = pool[*link].data;
+            node = *link;
+        }
+        *link = pool[node].left != 0 ? pool[node].left : pool[node].right;
+        pool.release(node);
+        --count;
+        rebalancePath(path, depth);
+        return true;
+    }
+
+    bool contains(int value) const {
+        uint32_t node = root;
+        while (node != 0) {
+            const PoolNode& n = pool[node];
+            if (value == n.data) {
+                return true;
+            }
+            node = value < n.data ? n.left : n.right;
+        }
+        return false;
+    }
+
+    // Загрузка отсортированных ключей за O(n): узлы выделяются подряд в порядке ключей
+    void buildSorted(const vector<int>& keys) {
+        clear();
+        count = CountSortedUnique(keys);
+        size_t pos = 0;
+        root = BuildBalanced(count, (uint32_t)0, [&] {
+            while (pos > 0 && pos < keys.size() && keys[pos] == keys[pos - 1]) {
+                ++pos;
+            }
+            return pool.allocate(keys[pos++]);
+        }, [&](uint32_t node, uint32_t left, uint32_t right) {
+            pool[node].left = left;
+            pool[node].right = right;
+            fixHeight(node);
+        });
+    }
+
+    // Удаление всего дерева: блоки пула освобождаются целиком
+    void clear() {
+        pool.clear();
+        root = 0;
+        count = 0;
+    }
+};
+
+// Замороженное дерево только для чтения в раскладке Эйтцингера: узел k хранится в
+// keys[k], его дети - в 2k и 2k + 1. Верхние уровни дерева лежат рядом в памяти,
+// а поиск не содержит условных переходов: на каждом уровне номер узла вычисляется
+// из результата сравнения, следующие уровни заранее подкачиваются в кэш.
+struct FrozenAVL {
+    vector<int> keys; // keys[0] не используется
+    size_t n = 0;
+
+    // Заполнение из n ключей, выдаваемых next() по возрастанию: обход неявного
+    // дерева в симметричном порядке вычисляется по номерам, без стека
+    template <typename Next>
+    void fill(size_t count, Next next) {
+        n = count;
+        keys.assign(n + 1, 0);
+        if (n == 0) {
+            return;
+        }
+        size_t k = 1;
+        while (2 * k <= n) {
+            k *= 2; // Самый левый узел
+        }
+        while (k != 0) {
+            keys[k] = next();
+            if (2 * k + 1 <= n) {
+                k = 2 * k + 1; // Спуск в правое поддерево и к его самому левому узлу
+                while (2 * k <= n) {
+                    k *= 2;
+                }
+            } else {
+                while (k & 1) {
+                    k >>= 1; // Подъем, пока узел - правый ребенок
+                }
+                k >>= 1;
+            }
+        }
+    }
+
+    // Заморозка дерева на указателях
+    void freeze(const AVLTree& tree) {
+        AVLNode* stack[AVLTree::MAX_DEPTH];
+        int top = 0;
+        AVLNode* node = tree.root;
+        fill(tree.count, [&] {
+            while (node != nullptr) {
+                stack[top++] = node;
+                node = node->left;
+            }
+            AVLNode* current = stack[--top];
+            node = current->right;
+            return current->data;
+        });
+    }
+
+    // Заморозка дерева из пула
+    void freeze(const PooledAVLTree& tree) {
+        uint32_t stack[AVLTree::MAX_DEPTH];
+        int top = 0;
+        uint32_t node = tree.root;
+        fill(tree.count, [&] {
+            while (node != 0) {
+                stack[top++] = node;
+                node = tree.pool[node].left;
+            }
+            uint32_t current = stack[--top];
+            node = tree.pool[current].right;
+            return tree.pool[current].data;
+        });
+    }
+
+    // Поиск без ветвлений
+    bool contains(int value) const {
+        const int* data = keys.data();
+        size_t k = 1;
+        while (k <= n) {
+            __builtin_prefetch(data + k * 16); // Узлы через 4 уровня: одна строка кэша
+            k = 2 * k + (data[k] < value);
+        }
+        k >>= __builtin_ffsll(~k); // Отмена правых шагов после последнего шага влево
+        return k != 0 && data[k] == value;
+    }
+};
+
+// Эпохи для безопасного освобождения памяти при чтении без блокировок.
+// Читатель на время обхода публикует текущую глобальную эпоху в своем слоте.
+// Объект, исключенный из дерева в эпоху r, можно освободить, когда все активные
+// читатели вошли в эпоху позже r: они начали обход уже после его исключения.
+struct EpochManager {
+    static constexpr int MAX_THREADS = 256;      // Максимум одновременно читающих потоков
+    static constexpr uint64_t IDLE = UINT64_MAX; // Поток сейчас не читает
+
+    struct alignas(64) Slot {
+        atomic<uint64_t> epoch{IDLE}; // Эпоха входа читателя
+        atomic<bool> used{false};     // Слот закреплен за потоком
+        int nesting = 0;              // Глубина вложенных чтений (меняет только владелец)
+    };
+
+    atomic<uint64_t> globalEpoch{1}; // Глобальная эпоха
+    Slot slots[MAX_THREADS];         // Слоты потоков
+
+    // Единственный экземпляр на процесс
+    static EpochManager& instance() {
+        static EpochManager manager;
+        return manager;
+    }
+
+    // Слот текущего потока (закрепляется при первом обращении, освобождается при завершении потока)
+    int threadSlot() {
+        struct Registration {
+            int slot = -1;
+            ~Registration() {
+                if (slot >= 0) {
+                    EpochManager::instance().slots[slot].used.store(false);
+                }
+            }
+        };
+        thread_local Registration registration;
+        if (registration.slot < 0) {
+            for (int i = 0; i < MAX_THREADS; ++i) {
+                bool expected = false;
+                if (slots[i].used.compare_exchange_strong(expected, true)) {
+                    registration.slot = i;
+                    break;
+                }
+            }
+            if (registration.slot < 0) {
+                throw runtime_error("слишком много читающих потоков");
+            }
+        }
+        return registration.slot;
+    }
+
+    // Начало чтения; вложенное чтение сохраняет эпоху внешнего
+    void enter(int slot) {
+        if (slots[slot].nesting++ == 0) {
+            slots[slot].epoch.store(globalEpoch.load(), memory_order_seq_cst);
+            atomic_thread_fence(memory_order_seq_cst); // Публикация эпохи до чтения указателей
+        }
+    }
+
+    // Конец чтения
+    void leave(int slot) {
+        if (--slots[slot].nesting == 0) {
+            slots[slot].epoch.store(IDLE, memory_order_release);
+        }
+    }
+
+    // Минимальная эпоха активных читателей; если все догнали глобальную эпоху, она продвигается
+    uint64_t minActiveEpoch() {
+        atomic_thread_fence(memory_order_seq_cst);
+        uint64_t global = globalEpoch.load();
+        uint64_t minimum = global;
+        for (int i = 0; i < MAX_THREADS; ++i) {
+            minimum = min(minimum, slots[i].epoch.load());
+        }
+        if (minimum == global) {
+            globalEpoch.compare_exchange_strong(global, global + 1);
+        }
+        return minimum;
+    }
+};
+
+// Неизменяемый узел персистентного дерева
+struct PNode {
+    int data;           // Значение узла
+    int height;         // Высота поддерева
+    const PNode* left;  // Левое поддерево
+    const PNode* right; // Правое поддерево
+    uint64_t birth;     // Номер вставки, создавшей узел
+};
+
+// Персистентное AVL-дерево с копированием пути. Вставка не меняет существующие узлы:
+// копируется только путь от корня до нового листа (и узлы, затронутые вращениями),
+// остальные поддеревья общие у старой и новой версии. Каждая вставка публикует новую
+// версию одним атомарным указателем; читатель закрепляет версию и обходит ее без
+// блокировок. Узлы, выпавшие из новой версии, освобождаются по эпохам, когда их уже
+// не может видеть ни один читатель. Писатели выполняются по очереди.
+struct PersistentAVL {
+    // Опубликованная версия дерева
+    struct Version {
+        const PNode* root; // Корень версии
+        uint64_t number;   // Номер версии (количество выполненных вставок)
+        size_t count;      // Количество ключей
+    };
+
+    // Объект, ожидающий освобождения
+    struct Retired {
+        uint64_t epoch;         // Эпоха исключения
+        const PNode* node;      // Узел (или nullptr)
+        const Version* version; // Версия (или nullptr)
+    };
+
+    // Закрепленная версия: пока объект жив, ее узлы не освобождаются
+    struct Snapshot {
+        int slot;
+        const Version* version;
+
+        Snapshot(const PersistentAVL& tree) : slot(EpochManager::instance().threadSlot()) {
+            EpochManager::instance().enter(slot);
+            version = tree.current.load(memory_order_acquire);
+        }
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        ~Snapshot() {
+            EpochManager::instance().leave(slot);
+        }
+
+        bool contains(int value) const {
+            const PNode* node = version->root;
+            while (node != nullptr) {
+                if (value == node->data) {
+                    return true;
+                }
+                node = value < node->data ? node->left : node->right;
+            }
+            return false;
+        }
+    };
+
+    atomic<const Version*> current; // Текущая версия
+    mutex writeLock;                // Блокировка писателей
+    uint64_t operation = 0;         // Номер текущей вставки
+    vector<const PNode*> garbage;   // Узлы, выпавшие при текущей вставке
+    vector<Retired> retired;        // Объекты, ожидающие освобождения
+    size_t copiedNodes = 0;         // Создано узлов (статистика)
+    size_t freedNodes = 0;          // Освобождено узлов (статистика)
+
+    PersistentAVL() : current(new Version{nullptr, 0, 0}) {}
+    PersistentAVL(const PersistentAVL&) = delete;
+    PersistentAVL& operator=(const PersistentAVL&) = delete;
+
+    // Удаление без активных читателей
+    ~PersistentAVL() {
+        for (Retired& r : retired) {
+            free(r);
+        }
+        const Version* version = current.load();
+        const PNode* stack[AVLTree::MAX_DEPTH];
+        int top = 0;
+        if (version->root != nullptr) {
+            stack[top++] = version->root;
+        }
+        while (top > 0) {
+            const PNode* node = stack[--top];
+            if (node->left != nullptr) stack[top++] = node->left;
+            if (node->right != nullptr) stack[top++] = node->right;
+            delete node;
+        }
+        delete version;
+    }
+
+    static int height(const PNode* node) {
+        return node == nullptr ? 0 : node->height;
+    }
+
+    // Новый узел с заданными детьми
+    const PNode* make(int data, const PNode* left, const PNode* right) {
+        ++copiedNodes;
+        return new PNode{data, max(height(left), height(right)) + 1, left, right, operation};
+    }
+
+    // Узел больше не входит в строящуюся версию: еще не опубликованный удаляется сразу,
+    // опубликованный ждет освобождения по эпохам
+    void discard(const PNode* node) {
+        if (node->birth == operation) {
+            delete node;
+            ++freedNodes;
+        } else {
+            garbage.push_back(node);
+        }
+    }
+
+    // Сборка сбалансированного узла из ключа и двух AVL-поддеревьев, высоты которых
+    // отличаются не больше чем на 2; вращения строят новые узлы вместо изменения старых
+    const PNode* balance(int data, const PNode* left, const PNode* right) {
+        int leftHeight = height(left), rightHeight = height(right);
+        if (leftHeight > rightHeight + 1) {
+            if (height(left->left) >= height(left->right)) {
+                // Левый левый случай
+                const PNode* result = make(left->data, left->left, make(data, left->right, right));
+                discard(left);
+                return result;
+            }
+            // Левый правый случай
+            const PNode* middle = left->right;
+            const PNode* result = make(middle->data, make(left->data, left->left, middle->left),
+                                       make(data, middle->right, right));
+            discard(left);
+            discard(middle);
+            return result;
+        }
+        if (rightHeight > leftHeight + 1) {
+            if (height(right->right) >= height(right->left)) {
+                // Правый правый случай
+                const PNode* result = make(right->data, make(data, left, right->left), right->right);
+                discard(right);
+                return result;
+            }
+            // Правый левый случай
+            const PNode* middle = right->left;
+            const PNode* result = make(middle->data, make(data, left, middle->left),
+                                       make(right->data, middle->right, right->right));
+            discard(right);
+            discard(middle);
+            return result;
+        }
+        return make(data, left, right);
+    }
+
+    // Вставка ключа с публикацией новой версии; false, если ключ уже есть
+    bool insert(int value) {
+        lock_guard<mutex> guard(writeLock);
+        const Version* old = current.load(memory_order_relaxed);
+        const PNode* path[AVLTree::MAX_DEPTH];
+        bool wentLeft[AVLTree::MAX_DEPTH];
+        int depth = 0;
+        for (const PNode* node = old->root; node != nullptr; ++depth) {
+            if (value == node->data) {
+                return false;
+            }
+            path[depth] = node;
+            wentLeft[depth] = value < node->data;
+            node = wentLeft[depth] ? node->left : node->right;
+        }
+        ++operation;
+        // Подъем от нового листа: каждый узел пути заменяется копией с новым ребенком
+        const PNode* subtree = make(value, nullptr, nullptr);
+        while (depth > 0) {
+            --depth;
+            const PNode* node = path[depth];
+            subtree = wentLeft[depth] ? balance(node->data, subtree, node->right)
+                                      : balance(node->data, node->left, subtree);
+            discard(node);
+        }
+        current.store(new Version{subtree, old->number + 1, old->count + 1}, memory_order_release);
+
+        // Выпавшие узлы и старая версия помечаются эпохой после публикации. Барьер не дает
+        // чтению эпохи обогнать публикацию (как в enter): иначе писатель другого дерева может
+        // продвинуть эпоху, и устаревшая метка освободит узлы, которые читатель еще видит
+        EpochManager& epochs = EpochManager::instance();
+        atomic_thread_fence(memory_order_seq_cst);
+        uint64_t epoch = epochs.globalEpoch.load();
+        for (const PNode* node : garbage) {
+            retired.push_back(Retired{epoch, node, nullptr});
+        }
+        garbage.clear();
+        retired.push_back(Retired{epoch, nullptr, old});
+        if (retired.size() >= 1024) {
+            reclaim();
+        }
+        return true;
+    }
+
+    // Освобождение объектов, которые не видит ни один читатель
+    void reclaim() {
+        uint64_t safe = EpochManager::instance().minActiveEpoch();
+        size_t kept = 0;
+        for (Retired& r : retired) {
+            if (r.epoch < safe) {
+                free(r);
+            } else {
+                retired[kept++] = r;
+            }
+        }
+        retired.resize(kept);
+    }
+
+    void free(Retired& r) {
+        if (r.node != nullptr) {
+            delete r.node;
+            ++freedNodes;
+        } else {
+            delete r.version;
+        }
+    }
+
+    // Поиск в текущей версии без блокировок
+    bool contains(int value) const {
+        return Snapshot(*this).contains(value);
+    }
+};
+
+// Время выполнения func в секундах
+template <typename Func>
+double measureSeconds(Func func) {
+    auto begin = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+// Ключи для бенчмарка: по возрастанию, по убыванию или случайные
+vector<int> makeKeys(size_t n, int order) {
+    vector<int> keys(n);
+    unsigned seed = 12345;
+    for (size_t i = 0; i < n; ++i) {
+        if (order == 0) {
+            keys[i] = (int)i;
+        } else if (order == 1) {
+            keys[i] = (int)(n - i);
+        } else {
+            seed = seed * 1103515245u + 12345u;
+            keys[i] = (int)(seed >> 1);
+        }
+    }
+    return keys;
+}
+
+// Случайные вставки и удаления в сравнении с std::set
+void runDifferentialTest(int operations) {
+    AVLTree tree;
+    PooledAVLTree pooled;
+    set<int> reference;
+    unsigned seed = 2024;
+    int mismatches = 0;
+    for (int i = 0; i < operations; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        int value = (seed >> 16) % 2000;
+        bool expected, actual;
+        if ((seed >> 8) % 3 == 0) {
+            expected = reference.erase(value) > 0;
+            actual = tree.erase(value);
+            mismatches += pooled.erase(value) != expected;
+        } else {
+            expected = reference.insert(value).second;
+            actual = tree.insert(value);
+            mismatches += pooled.insert(value) != expected;
+        }
+        if (expected != actual || tree.count != reference.size() || pooled.count != reference.size() ||
+            (i % 1000 == 0 && !ValidateTree(tree.root).valid())) {
+            ++mismatches;
+        }
+        if (i % 5000 == 0 && !reference.empty()) {
+            // Порядковые запросы сравниваются с подсчетом по std::set
+            int low = (seed >> 4) % 2000, high = low + (seed >> 12) % 300;
+            auto first = reference.lower_bound(low), last = reference.upper_bound(high);
+            size_t k = (seed >> 3) % reference.size();
+            int sum = 0, value;
+            for (auto cursor = tree.range(low, high); cursor.next(value);) {
+                sum += value;
+            }
+            int expectedSum = 0;
+            for (auto it = first; it != last; ++it) {
+                expectedSum += *it;
+            }
+            mismatches += tree.rank(low) != (size_t)distance(reference.begin(), first) ||
+                          tree.countRange(low, high) != (size_t)distance(first, last) ||
+                          tree.select(k) != *next(reference.begin(), k) || sum != expectedSum;
+        }
+        if (i % 10000 == 0) {
+            // Замороженные копии обоих деревьев отвечают так же, как std::set
+            FrozenAVL frozen, frozenPooled;
+            frozen.freeze(tree);
+            frozenPooled.freeze(pooled);
+            for (int probe = -1; probe <= 2000; ++probe) {
+                bool present = reference.count(probe) > 0;
+                mismatches += frozen.contains(probe) != present || frozenPooled.contains(probe) != present ||
+                              pooled.contains(probe) != present;
+            }
+        }
+    }
+    cout << "Случайных операций: " << operations << ", расхождений: " << mismatches << endl;
+}
+
+// Бенчмарк: AVLTree против Insert + BalanceTree на упорядоченных и случайных ключах
+void runBenchmark(size_t n) {
+    runDifferentialTest(200000);
+    const char* orders[] = {"по возрастанию", "по убыванию", "случайные"};
+    // Старый способ квадратичен на упорядоченных ключах и рекурсивен по глубине дерева
+    size_t legacyN = min(n, (size_t)10000);
+    for (int order = 0; order < 3; ++order) {
+        vector<int> keys = makeKeys(n, order);
+        AVLTree tree;
+        double seconds = measureSeconds([&] {
+            for (int key : keys) tree.insert(key);
+        });
+        double eraseSeconds = measureSeconds([&] {
+            for (size_t i = 0; i < keys.size(); i += 2) tree.erase(keys[i]);
+        });
+
+        AVLNode* legacy = nullptr;
+        double legacySeconds = measureSeconds([&] {
+            for (size_t i = 0; i < legacyN; ++i) legacy = Insert(legacy, keys[i]);
+            legacy = BalanceTree(legacy);
+        });
+        cout << orders[order] << ": AVLTree " << n << " ключей за " << seconds * 1000 << " мс ("
+             << seconds / n * 1e9 << " нс/ключ, высота " << AVLTree::height(tree.root) << "), удаление половины "
+             << eraseSeconds * 1000 << " мс; Insert + BalanceTree " << legacyN << " ключей за "
+             << legacySeconds * 1000 << " мс (" << legacySeconds / legacyN * 1e9 << " нс/ключ, высота "
+             << HeightAVL(legacy) << ")" << endl;
+        FreeTree(legacy);
+    }
+}
+
+// Бенчмарк пакетной загрузки: построение из отсортированных и случайных ключей,
+// перестройка дерева после вставок и перестройка вырожденного дерева
+void runBuildBenchmark(size_t n) {
+    vector<int> sorted = makeKeys(n, 0);
+    AVLTree tree;
+    double seconds = measureSeconds([&] { tree.buildSorted(sorted); });
+    cout << "Построение из " << n << " отсортированных ключей: " << seconds * 1000 << " мс, высота "
+         << AVLTree::height(tree.root) << endl;
+    tree.clear();
+    vector<int>().swap(sorted);
+
+    vector<int> random = makeKeys(n, 2);
+    seconds = measureSeconds([&] { tree.build(random); });
+    cout << "Сортировка и построение из " << n << " случайных ключей: " << seconds * 1000 << " мс, ключей "
+         << tree.count << ", высота " << AVLTree::height(tree.root) << endl;
+    tree.clear();
+
+    size_t inserted = min(n, (size_t)1000000);
+    for (size_t i = 0; i < inserted; ++i) tree.insert(random[i]);
+    int before = AVLTree::height(tree.root);
+    seconds = measureSeconds([&] { tree.rebuild(); });
+    cout << "Перестройка дерева из " << tree.count << " вставленных ключей: " << seconds * 1000 << " мс, высота "
+         << before << " -> " << AVLTree::height(tree.root) << endl;
+    tree.clear();
+    vector<int>().swap(random);
+
+    // Вырожденное дерево, как после Insert с ключами по возрастанию (цепочка вправо)
+    AVLNode* chain = nullptr;
+    for (size_t i = n; i-- > 0;) {
+        AVLNode* node = new AVLNode{(int)i};
+        node->right = chain;
+        chain = node;
+    }
+    size_t count = 0;
+    seconds = measureSeconds([&] { chain = RebuildTree(chain, &count); });
+    cout << "Перестройка вырожденного дерева из " << count << " узлов: " << seconds * 1000 << " мс, высота "
+         << AVLTree::height(chain) << (ValidateTree(chain).valid() ? "" : " (ОШИБКА)") << endl;
+    FreeTree(chain);
+}
+
+// Бенчмарк поиска: узлы на указателях, узлы в пуле и замороженная раскладка.
+// Ключи - четные числа 0..2n, запросы случайны, поэтому находится примерно половина.
+void runLayoutBenchmark(size_t maxKeys) {
+    const size_t queryCount = 2000000;
+    for (size_t n = 1000000; n <= maxKeys; n *= 10) {
+        vector<int> keys(n);
+        for (size_t i = 0; i < n; ++i) {
+            keys[i] = (int)(2 * i);
+        }
+        vector<int> queries(queryCount);
+        unsigned seed = 777;
+        for (int& query : queries) {
+            seed = seed * 1103515245u + 12345u;
+            query = (int)(((uint64_t)seed * 2 * n) >> 32);
+        }
+        cout << n << " ключей:";
+        auto report = [&](const char* name, size_t found, double seconds) {
+            cout << " " << name << " " << queryCount / seconds / 1e6 << " млн/с (найдено " << found << ")";
+        };
+
+        // Узел на указателях с накладными расходами malloc занимает около 48 байт
+        if (n <= 50000000) {
+            AVLTree tree;
+            tree.buildSorted(keys);
+            size_t found = 0;
+            double seconds = measureSeconds([&] {
+                for (int query : queries) found += tree.contains(query);
+            });
+            report("указатели", found, seconds);
+        } else {
+            cout << " указатели пропущены (не хватит памяти)";
+        }
+
+        FrozenAVL frozen;
+        {
+            PooledAVLTree pooled;
+            pooled.buildSorted(keys);
+            size_t found = 0;
+            double seconds = measureSeconds([&] {
+                for (int query : queries) found += pooled.contains(query);
+            });
+            report("пул", found, seconds);
+            vector<int>().swap(keys);
+            frozen.freeze(pooled);
+        }
+        size_t found = 0;
+        double seconds = measureSeconds([&] {
+            for (int query : queries) found += frozen.contains(query);
+        });
+        report("заморожено", found, seconds);
+        cout << endl;
+    }
+}
+
+// Обход ключей по возрастанию (для сравнения с порядковыми запросами); visit
+// возвращает false, чтобы остановить обход
+template <typename Visit>
+void TraverseInOrder(AVLNode* root, Visit visit) {
+    AVLNode* stack[AVLTree::MAX_DEPTH];
+    int top = 0;
+    AVLNode* node = root;
+    while (node != nullptr || top > 0) {
+        while (node != nullptr) {
+            stack[top++] = node;
+            node = node->left;
+        }
+        node = stack[--top];
+        if (!visit(node->data)) {
+            return;
+        }
+        node = node->right;
+    }
+}
+
+// Бенчмарк порядковых запросов: rank/select/countRange и курсор по отрезку
+// против линейного обхода дерева
+void runOrderBenchmark(size_t n) {
+    vector<int> keys = makeKeys(n, 2);
+    AVLTree tree;
+    tree.build(keys);
+    const int queryCount = 200000;
+    const int linearCount = 200; // Линейный обход медленный: берется меньше запросов
+    vector<int> lows(queryCount), highs(queryCount);
+    unsigned seed = 4242;
+    for (int i = 0; i < queryCount; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        lows[i] = (int)(seed >> 1);
+        seed = seed * 1103515245u + 12345u;
+        highs[i] = lows[i] + (int)min(seed >> 12, (unsigned)(INT32_MAX - lows[i])); // Отрезок шириной до 2^20
+    }
+
+    size_t fastCount = 0, linearCountTotal = 0, fastPart = 0;
+    double fastSeconds = measureSeconds([&] {
+        for (int i = 0; i < queryCount; ++i) fastCount += tree.countRange(lows[i], highs[i]);
+    });
+    double linearSeconds = measureSeconds([&] {
+        for (int i = 0; i < linearCount; ++i) {
+            TraverseInOrder(tree.root, [&](int key) {
+                linearCountTotal += key >= lows[i] && key <= highs[i];
+                return key <= highs[i];
+            });
+        }
+    });
+    for (int i = 0; i < linearCount; ++i) fastPart += tree.countRange(lows[i], highs[i]);
+    cout << "countRange (" << tree.count << " ключей, всего найдено " << fastCount << "): "
+         << fastSeconds / queryCount * 1e9 << " нс/запрос, обход "
+         << linearSeconds / linearCount * 1e6 << " мкс/запрос" << (fastPart == linearCountTotal ? "" : " (РЕЗУЛЬТАТЫ РАЗЛИЧАЮТСЯ)") << endl;
+
+    long long selectSum = 0, linearSelectSum = 0, selectPart = 0;
+    fastSeconds = measureSeconds([&] {
+        for (int i = 0; i < queryCount; ++i) selectSum += tree.select((size_t)lows[i] % tree.count);
+    });
+    linearSeconds = measureSeconds([&] {
+        for (int i = 0; i < linearCount; ++i) {
+            size_t k = (size_t)lows[i] % tree.count;
+            TraverseInOrder(tree.root, [&](int key) {
+                if (k-- == 0) {
+                    linearSelectSum += key;
+                    return false;
+                }
+                return true;
+            });
+        }
+    });
+    for (int i = 0; i < linearCount; ++i) selectPart += tree.select((size_t)lows[i] % tree.count);
+    cout << "select (сумма " << selectSum << "): " << fastSeconds / queryCount * 1e9 << " нс/запрос, обход "
+         << linearSeconds / linearCount * 1e6 << " мкс/запрос" << (selectPart == linearSelectSum ? "" : " (РЕЗУЛЬТАТЫ РАЗЛИЧАЮТСЯ)") << endl;
+
+    // Перебор ключей отрезка курсором: затраты пропорциональны log n + числу ключей
+    long long cursorSum = 0, linearRangeSum = 0, cursorPart = 0;
+    fastSeconds = measureSeconds([&] {
+        for (int i = 0; i < queryCount; ++i) {
+            int value;
+            for (auto cursor = tree.range(lows[i], highs[i]); cursor.next(value);) cursorSum += value;
+        }
+    });
+    linearSeconds = measureSeconds([&] {
+        for (int i = 0; i < linearCount; ++i) {
+            TraverseInOrder(tree.root, [&](int key) {
+                if (key >= lows[i] && key <= highs[i]) linearRangeSum += key;
+                return key <= highs[i];
+            });
+        }
+    });
+    for (int i = 0; i < linearCount; ++i) {
+        int value;
+        for (auto cursor = tree.range(lows[i], highs[i]); cursor.next(value);) cursorPart += value;
+    }
+    cout << "курсор по отрезку (сумма " << cursorSum << "): " << fastSeconds / queryCount * 1e9 << " нс/запрос, обход "
+         << linearSeconds / linearCount * 1e6 << " мкс/запрос" << (cursorPart == linearRangeSum ? "" : " (РЕЗУЛЬТАТЫ РАЗЛИЧАЮТСЯ)") << endl;
+}
+
+// Бенчмарк чтения версий: читатели ищут случайные ключи без блокировок, пока
+// писатель вставляет ключи с постоянной скоростью; число читателей удваивается
+void runPersistentBenchmark(int maxThreads) {
+    const size_t initialKeys = 500000;
+    const int writesPerMs = 50; // Скорость писателя: 50000 вставок в секунду
+    const auto duration = chrono::milliseconds(500);
+    PersistentAVL tree;
+    unsigned seed = 99;
+    for (size_t i = 0; i < initialKeys; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        tree.insert((int)(seed >> 1));
+    }
+    cout << "Начальное дерево: " << tree.current.load()->count << " ключей" << endl;
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        atomic<bool> stop{false};
+        atomic<size_t> reads{0}, hits{0};
+        size_t inserted = 0;
+        size_t freedBefore = tree.freedNodes;
+        thread writer([&] {
+            unsigned writerSeed = 1234 + threads;
+            auto next = chrono::steady_clock::now();
+            while (!stop.load(memory_order_relaxed)) {
+                for (int i = 0; i < writesPerMs; ++i) {
+                    writerSeed = writerSeed * 1103515245u + 12345u;
+                    inserted += tree.insert((int)(writerSeed >> 1));
+                }
+                next += chrono::milliseconds(1);
+                this_thread::sleep_until(next);
+            }
+        });
+        vector<thread> readers;
+        for (int t = 0; t < threads; ++t) {
+            readers.emplace_back([&, t] {
+                unsigned readerSeed = 777 + t;
+                size_t local = 0, found = 0;
+                while (!stop.load(memory_order_relaxed)) {
+                    for (int i = 0; i < 256; ++i) {
+                        readerSeed = readerSeed * 1103515245u + 12345u;
+                        found += tree.contains((int)(readerSeed >> 1));
+                    }
+                    local += 256;
+                }
+                reads += local;
+                hits += found;
+            });
+        }
+        this_thread::sleep_for(duration);
+        stop = true;
+        writer.join();
+        for (thread& reader : readers) {
+            reader.join();
+        }
+        double seconds = chrono::duration<double>(duration).count();
+        cout << threads << " читателей: " << reads / seconds / 1e6 << " млн поисков/с ("
+             << reads / seconds / 1e6 / threads << " на поток, найдено " << 100.0 * hits / max((size_t)reads, (size_t)1)
+             << "%), вставок " << inserted << ", освобождено узлов "
+             << tree.freedNodes - freedBefore << ", ожидают освобождения " << tree.retired.size() << endl;
+    }
+}
+
+// Проверка дерева после случайных вставок и удалений и проверка вырожденного дерева,
+// на котором рекурсивная IsBalanced переполняла стек; счетчики выводятся в JSON
+void runValidateBenchmark(size_t n) {
+    AVLTree tree;
+    unsigned seed = 31;
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        tree.insert((int)(seed >> 1));
+        if (i % 4 == 3) {
+            tree.erase((int)(seed >> 1));
+        }
+    }
+    TreeStats stats;
+    double seconds = measureSeconds([&] { stats = ValidateTree(tree.root); });
+    cout << "Проверка AVLTree из " << stats.nodes << " узлов: " << seconds * 1000 << " мс, "
+         << (stats.valid() ? "корректно" : "ОШИБКА") << endl;
+    cout << tree.statsJson() << endl;
+
+    // Вырожденное дерево, как после Insert с ключами по возрастанию
+    AVLNode* chain = nullptr;
+    for (size_t i = n; i-- > 0;) {
+        AVLNode* node = new AVLNode{(int)i};
+        node->right = chain;
+        chain = node;
+    }
+    seconds = measureSeconds([&] { stats = ValidateTree(chain); });
+    cout << "Проверка вырожденного дерева из " << stats.nodes << " узлов: " << seconds * 1000 << " мс, высота "
+         << stats.height << ", сбалансировано: " << (stats.balanced ? "да" : "нет") << ", худший дисбаланс "
+         << stats.worstImbalance << " у ключа " << stats.worstImbalanceKey << endl;
+    FreeTree(chain);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--validate") {
+        runValidateBenchmark(argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-persistent") {
+        runPersistentBenchmark(argc > 2 ? atoi(argv[2]) : (int)thread::hardware_concurrency());
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-order") {
+        runOrderBenchmark(argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-layout") {
+        runLayoutBenchmark(argc > 2 ? strtoull(argv[2], nullptr, 10) : 10000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-build") {
+        runBuildBenchmark(argc > 2 ? strtoull(argv[2], nullptr, 10) : 10000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runBenchmark(argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000); // Режим замера производительности
+        return 0;
+    }
+
+    system("chcp 65001"); // Устанавливаем кодировку консоли на UTF-8
+    AVLTree tree; // Самобалансирующееся дерево: отсортированный ввод не вырождает его в список
+    int value;
+
+    cout << "Введите числа (нечисло для завершения): "; // Запрос ввода чисел
+    while (cin >> value) {
+        tree.insert(value); // Итеративная вставка с балансировкой за O(log n)
+    }
+
+    // Проверка сбалансированности дерева после вставок
+    if (IsBalanced(tree.root)) {
+        cout << "дерево сбалансировано." << endl;
+    } else {
+        cout << "дерево не сбалансировано." << endl;
+    }
+    const AVLTree::Counters& c = tree.counters;
+    cout << "Поворотов при вставке: "
+         << c.rotationsLeft + c.rotationsRight + c.rotationsLeftRight + c.rotationsRightLeft << endl;
+
+    // Перестройка всего дерева за O(n) дает идеально сбалансированное дерево
+    tree.rebuild();
+
+    // Проверка сбалансированности после перестройки
+    if (IsBalanced(tree.root)) {
+        cout << "После балансировки дерево сбалансировано." << endl;
+    } else {
+        cout << "После балансировки дерево несбалансировано." << endl;
+    }
+
+    return 0; // Завершение программы
+}
@@ -1,124 +1,550 @@
-#include <iostream>
-#include <string>
-
-using namespace std;
-
-// Определение структуры узла для хеш-таблицы
-struct Node {
-    char key;           // Символ, который мы будем хранить в узле
-    int index;         // Индекс символа в строке
-    Node* next;        // Указатель на следующий узел
-
-    // Конструктор структуры для инициализации узла с символом и его индексом
-    Node(char k, int idx) : key(k), index(idx), next(nullptr) {}
-};
-
-// Определение класса хеш-таблицы
-class Hash {
-public:
-    static const int size = 256;   // Определяем размер хеш-таблицы (256, чтобы вместить все символы ASCII)
-    Node* table[size];             // Массив указателей на узлы (представляет хеш-таблицу)
-
-    // Конструктор хеш-таблицы
-    Hash() {
-        for (int i = 0; i < size; i++) {
-            table[i] = nullptr;     // Инициализируем все элементы таблицы значением nullptr
-        }
-    }
-
-    // Хеш-функция, которая принимает символ и возвращает индекс
-    int hash(char key) {
-        return key; // Используем значение символа как индекс
-    }
-
-    // Метод для вставки символа в хеш-таблицу
-    bool insert(char key, int index) {
-        int idx = hash(key); // Получаем индекс для данного символа
-
-        // Проверка на наличие символа в таблице
-        Node* current = table[idx]; // Доступ к списку узлов по индексу
-        while (current != nullptr) {
-            if (current->key == key) {
-                if (current->index < index) {
-                    current->index = index; // Обновляем индекс, если он меньше
-                }
-                return false; // Если символ уже существует в списке, возвращаем false
-            }
-            current = current->next; // Переходим к следующему узлу в списке
-        }
-
-        // Если символ не найден, добавляем новый узел
-        Node* newNode = new Node(key, index); // Создаем новый узел с данным символом
-        newNode->next = table[idx]; // Указываем, что следующий узел нового узла - текущая голова списка
-        table[idx] = newNode; // Устанавливаем новую голову списка на новый узел
-        return true; // Возвращаем true, так как символ успешно добавлен
-    }
-
-    // Метод для получения индекса символа
-    int getIndex(char key) {
-        int idx = hash(key); // Получаем индекс для данного символа
-        Node* current = table[idx]; // Доступ к списку узлов по индексу
-        while (current != nullptr) {
-            if (current->key == key) {
-                return current->index; // Возвращаем индекс символа
-            }
-            current = current->next; // Переходим к следующему узлу в списке
-        }
-        return -1; // Если символ не найден, возвращаем -1
-    }
-
-    // Метод для очистки хеш-таблицы и освобождения памяти
-    void clear() {
-        for (int i = 0; i < size; i++) { // Проходим по всем индексам в таблице
-            Node* current = table[i]; // Доступ к списку узлов по текущему индексу
-            while (current != nullptr) { // Пока есть узлы в списке
-                Node* temp = current; // Сохраняем текущий узел во временную переменную
-                current = current->next; // Переходим к следующему узлу
-                delete temp; // Освобождаем память, занятую текущим узлом
-            }
-            table[i] = nullptr; // Устанавливаем указатель на пустоту для текущего индекса
-        }
-    }
-
-    // Деструктор для автоматической очистки хеш-таблицы при уничтожении объекта
-    ~Hash() {
-        clear(); // При уничтожении объекта очищаем хеш-таблицу
-    }
-};
-
-int main() {
-    string s; // Объявляем строку для хранения пользовательского ввода
-    cout << "Введите строку: ";
-    getline(cin, s); // Читаем строку, включая пробелы
-
-    Hash hashTable; // Создаем экземпляр хеш-таблицы для хранения уникальных символов
-    int maxLength = 0; // Переменная для хранения максимальной длины подстроки
-    string longestSubstring; // Переменная для хранения самой длинной подстроки
-    int start = 0; // Начальный индекс текущей подстроки
-
-    // Проходим по строке
-    for (int end = 0; end < s.length(); ++end) {
-        char currentChar = s[end];
-
-        // Если символ уже встречался, перемещаем начальный индекс
-        int index = hashTable.getIndex(currentChar);
-        if (index != -1) {
-            start = max(start, index + 1); // Обновляем стартовый индекс
-        }
-
-        // Вставляем текущий символ в хеш-таблицу
-        hashTable.insert(currentChar, end);
-
-        // Проверяем длину текущей подстроки
-        if (end - start + 1 > maxLength) {
-            maxLength = end - start + 1; // Обновляем максимальную длину
-            longestSubstring = s.substr(start, maxLength); // Обновляем самую длинную подстроку
-        }
-    }
-
-    // Выводим результат
-    cout << maxLength << " (" << longestSubstring << ")" << endl;
-
-    return 0;
-}
-
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+// Определение структуры узла для хеш-таблицы
+struct Node {
+    char key;           // Символ, который мы будем хранить в узле
+    int index;         // Индекс символа в строке
+    Node* next;        // Указатель на следующий узел
+
+    // Конструктор структуры для инициализации узла с символом и его индексом
+    Node(char k, int idx) : key(k), index(idx), next(nullptr) {}
+};
+
+// Определение класса хеш-таблицы
+class Hash {
+public:
+    static const int size = 256;   // Определяем размер хеш-таблицы (256, чтобы вместить все символы ASCII)
+    Node* table[size];             // Массив указателей на узлы (представляет хеш-таблицу)
+
+    // Конструктор хеш-таблицы
+    Hash() {
+        for (int i = 0; i < size; i++) {
+            table[i] = nullptr;     // Инициализируем все элементы таблицы значением nullptr
+        }
+    }
+
+    // Хеш-функция, которая принимает символ и возвращает индекс
+    int hash(char key) {
+        return (unsigned char)key; // Байты >= 0x80 дают индексы 128..255, а не отрицательные
+    }
+
+    // Метод для вставки символа в хеш-таблицу
+    bool insert(char key, int index) {
+        int idx = hash(key); // Получаем индекс для данного символа
+
+        // Проверка на наличие символа в таблице
+        Node* current = table[idx]; // Доступ к списку узлов по индексу
+        while (current != nullptr) {
+            if (current->key == key) {
+                if (current->index < index) {
+                    current->index = index; // Обновляем индекс, если он меньше
+                }
+                return false; // Если символ уже существует в списке, возвращаем false
+            }
+            current = current->next; // Переходим к следующему узлу в списке
+        }
+
+        // Если символ не найден, добавляем новый узел
+        Node* newNode = new Node(key, index); // Создаем новый узел с данным символом
+        newNode->next = table[idx]; // Указываем, что следующий узел нового узла - текущая голова списка
+        table[idx] = newNode; // Устанавливаем новую голову списка на новый узел
+        return true; // Возвращаем true, так как символ успешно добавлен
+    }
+
+    // Метод для получения индекса символа
+    int getIndex(char key) {
+        int idx = hash(key); // Получаем индекс для данного символа
+        Node* current = table[idx]; // Доступ к списку узлов по индексу
+        while (current != nullptr) {
+            if (current->key == key) {
+                return current->index; // Возвращаем индекс символа
+            }
+            current = current->next; // Переходим к следующему узлу в списке
+        }
+        return -1; // Если символ не найден, возвращаем -1
+    }
+
+    // Метод для очистки хеш-таблицы и освобождения памяти
+    void clear() {
+        for (int i = 0; i < size; i++) { // Проходим по всем индексам в таблице
+            Node* current = table[i]; // Доступ к списку узлов по текущему индексу
+            while (current != nullptr) { // Пока есть узлы в списке
+                Node* temp = current; // Сохраняем текущий узел во временную переменную
+                current = current->next; // Переходим к следующему узлу
+                delete temp; // Освобождаем память, занятую текущим узлом
+            }
+            table[i] = nullptr; // Устанавливаем указатель на пустоту для текущего индекса
+        }
+    }
+
+    // Деструктор для автоматической очистки хеш-таблицы при уничтожении объекта
+    ~Hash() {
+        clear(); // При уничтожении объекта очищаем хеш-таблицу
+    }
+};
+
+// Поиск самой длинной подстроки без повторяющихся символов через хеш-таблицу
+// (исходный алгоритм; используется для сравнения с UniqueSubstringEngine)
+void longestUniqueHash(const string& s, int& maxLength, string& longestSubstring) {
+    Hash hashTable; // Создаем экземпляр хеш-таблицы для хранения уникальных символов
+    maxLength = 0; // Переменная для хранения максимальной длины подстроки
+    longestSubstring.clear(); // Переменная для хранения самой длинной подстроки
+    int start = 0; // Начальный индекс текущей подстроки
+
+    // Проходим по строке
+    for (size_t end = 0; end < s.length(); ++end) {
+        char currentChar = s[end];
+
+        // Если символ уже встречался, перемещаем начальный индекс
+        int index = hashTable.getIndex(currentChar);
+        if (index != -1) {
+            start = max(start, index + 1); // Обновляем стартовый индекс
+        }
+
+        // Вставляем текущий символ в хеш-таблицу
+        hashTable.insert(currentChar, end);
+
+        // Проверяем длину текущей подстроки
+        int length = (int)(end - start) + 1;
+        if (length > maxLength) {
+            maxLength = length; // Обновляем максимальную длину
+            longestSubstring = s.substr(start, maxLength); // Обновляем самую длинную подстроку
+        }
+    }
+
+}
+
+// Самая длинная подстрока без повторов: смещение и длина во входном потоке
+struct UniqueWindow {
+    uint64_t offset = 0; // Смещение начала в байтах
+    uint64_t bytes = 0;  // Длина в байтах
+    uint64_t units = 0;  // Длина в символах (байтах или кодовых точках UTF-8)
+};
+
+// Потоковый поиск самой длинной подстроки без повторяющихся символов.
+// Для каждого символа хранится позиция сразу после его последнего вхождения в плоском
+// массиве: окно начинается не раньше этой позиции. Вход подается порциями любого
+// размера, память не зависит от длины входа, в цикле нет выделений памяти.
+// В режиме UTF-8 символ - кодовая точка (таблица на 0x110000 точек выделяется один раз
+// через calloc: страницы обнуляются системой при первом обращении, поэтому короткий вход
+// затрагивает только нужные страницы), байт неверной последовательности - отдельный символ.
+// Позиции только растут, поэтому reset не очищает таблицы, а переносит начало отсчета.
+struct UniqueSubstringEngine {
+    static const uint32_t CODE_POINTS = 0x110000;
+
+    // Позиция сразу после вхождения символа (0 - символ не встречался)
+    struct Seen {
+        uint64_t byte;  // В байтах
+        uint64_t index; // В символах
+    };
+
+    // Положение во входе
+    struct Cursor {
+        uint64_t bytePos = 0;    // Обработано байтов
+        uint64_t index = 0;      // Обработано символов
+        uint64_t startByte = 0;  // Начало текущего окна
+        uint64_t startIndex = 0;
+        UniqueWindow best;       // Лучшее окно
+    };
+
+    bool utf8;                  // Режим кодовых точек UTF-8
+    uint64_t lastByte[256];     // Байтовый режим: позиция после последнего вхождения байта
+    Seen* lastSeen = nullptr;   // Режим UTF-8: по кодовой точке (и 256 неверных байтов)
+    Cursor cursor;
+    uint64_t baseByte = 0;      // Позиция последнего reset: смещения результата отсчитываются от нее
+    unsigned char pending[4];   // Начало кодовой точки, разрезанной границей порций
+    size_t pendingLength = 0;
+
+    UniqueSubstringEngine(bool utf8Mode = false) : utf8(utf8Mode) {
+        memset(lastByte, 0, sizeof(lastByte));
+        if (utf8) {
+            lastSeen = (Seen*)calloc(CODE_POINTS + 256, sizeof(Seen));
+            if (lastSeen == nullptr) {
+                throw bad_alloc();
+            }
+        }
+    }
+
+    ~UniqueSubstringEngine() {
+        free(lastSeen);
+    }
+
+    UniqueSubstringEngine(const UniqueSubstringEngine&) = delete;
+    UniqueSubstringEngine& operator=(const UniqueSubstringEngine&) = delete;
+
+    // Начало нового входа за O(1): окно начинается с текущей позиции, и все записи таблиц
+    // (они не больше нее) перестают влиять на результат
+    void reset() {
+        cursor.startByte = cursor.bytePos;
+        cursor.startIndex = cursor.index;
+        cursor.best = {cursor.bytePos, 0, 0};
+        baseByte = cursor.bytePos;
+        pendingLength = 0;
+    }
+
+    // Порция входа в байтовом режиме: позиция в байтах совпадает с номером символа.
+    // Таблица и состояние копируются в локальные переменные: иначе компилятор считает,
+    // что запись через unsigned char* может их изменить, и перечитывает из памяти
+    void feedBytes(const unsigned char* data, size_t n) {
+        uint64_t last[256];
+        memcpy(last, lastByte, sizeof(last));
+        uint64_t start = cursor.startByte;
+        uint64_t bestLength = cursor.best.bytes;
+        uint64_t bestOffset = cursor.best.offset;
+        uint64_t position = cursor.bytePos; // Позиция после текущего байта
+        for (size_t i = 0; i < n; ++i) {
+            ++position;
+            uint64_t& seen = last[data[i]];
+            start = max(start, seen); // Без ветвления: повторы в случайных данных не предсказать
+            seen = position;
+            if (position - start > bestLength) {
+                bestLength = position - start;
+                bestOffset = start;
+            }
+        }
+        memcpy(lastByte, last, sizeof(last));
+        cursor.best = {bestOffset, bestLength, bestLength};
+        cursor.startByte = cursor.startIndex = start;
+        cursor.bytePos = cursor.index = position;
+    }
+
+    // Очередной символ UTF-8 (slot - кодовая точка или CODE_POINTS + неверный байт) длиной length байт.
+    // Положение передается локальной копией: запись в таблицу не заставляет перечитывать его
+    static void consume(Cursor& at, Seen* table, uint32_t slot, size_t length) {
+        Seen& seen = table[slot];
+        // Позиции в байтах и символах растут вместе, поэтому начало окна сдвигается двумя
+        // независимыми max без ветвлений: повторы непредсказуемы
+        at.startIndex = max(at.startIndex, seen.index);
+        at.startByte = max(at.startByte, seen.byte);
+        at.bytePos += length;
+        ++at.index;
+        seen = {at.bytePos, at.index};
+        if (at.index - at.startIndex > at.best.units) {
+            at.best = {at.startByte, at.bytePos - at.startByte, at.index - at.startIndex};
+        }
+    }
+
+    // Разбор кодовой точки в s[0, available): количество байтов или 0, если последовательность
+    // не закончилась (и вход еще будет). Неверный первый байт - отдельный символ длиной 1
+    static size_t decode(const unsigned char* s, size_t available, bool final, uint32_t& slot) {
+        unsigned char lead = s[0];
+        if (lead < 0x80) {
+            slot = lead;
+            return 1;
+        }
+        size_t need;
+        unsigned char low = 0x80, high = 0xBF; // Допустимый второй байт
+        uint32_t cp;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            need = 2;
+            cp = lead & 0x1F;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            need = 3;
+            cp = lead & 0x0F;
+            if (lead == 0xE0) low = 0xA0;  // Без избыточных форм
+            if (lead == 0xED) high = 0x9F; // Без суррогатов
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            need = 4;
+            cp = lead & 0x07;
+            if (lead == 0xF0) low = 0x90;
+            if (lead == 0xF4) high = 0x8F; // Не больше U+10FFFF
+        } else {
+            slot = CODE_POINTS + lead;
+            return 1;
+        }
+        for (size_t k = 1; k < need; ++k) {
+            if (k >= available) {
+                if (final) {
+                    break;
+                }
+                return 0;
+            }
+            unsigned char c = s[k];
+            if (c < (k == 1 ? low : 0x80) || c > (k == 1 ? high : 0xBF)) {
+                break;
+            }
+            cp = (cp << 6) | (c & 0x3F);
+            if (k == need - 1) {
+                slot = cp;
+                return need;
+            }
+        }
+        slot = CODE_POINTS + lead; // Неверная или оборванная последовательность
+        return 1;
+    }
+
+    // Порция входа в режиме UTF-8
+    void feedUtf8(const unsigned char* data, size_t n) {
+        Cursor at = cursor;
+        Seen* table = lastSeen;
+        size_t i = 0;
+        // Сначала дописывается кодовая точка, начатая в прошлой порции
+        while (pendingLength > 0) {
+            uint32_t slot;
+            size_t used = decode(pending, pendingLength, false, slot);
+            if (used == 0) {
+                if (i == n) {
+                    cursor = at;
+                    return;
+                }
+                pending[pendingLength++] = data[i++];
+                continue;
+            }
+            consume(at, table, slot, used);
+            memmove(pending, pending + used, pendingLength - used);
+            pendingLength -= used;
+        }
+        while (i < n) {
+            if (data[i] < 0x80) {
+                consume(at, table, data[i], 1); // ASCII без разбора
+                ++i;
+                continue;
+            }
+            uint32_t slot;
+            size_t used = decode(data + i, n - i, false, slot);
+            if (used == 0) {
+                pendingLength = n - i; // Меньше 4 байтов: остаток ждет следующей порции
+                memcpy(pending, data + i, pendingLength);
+                break;
+            }
+            consume(at, table, slot, used);
+            i += used;
+        }
+        cursor = at;
+    }
+
+    // Порция входа любого размера
+    void feed(const char* data, size_t n) {
+        if (utf8) {
+            feedUtf8((const unsigned char*)data, n);
+        } else {
+            feedBytes((const unsigned char*)data, n);
+        }
+    }
+
+    // Конец входа: оборванная кодовая точка разбирается как неверные байты
+    UniqueWindow finish() {
+        while (pendingLength > 0) {
+            uint32_t slot;
+            size_t used = decode(pending, pendingLength, true, slot);
+            consume(cursor, lastSeen, slot, used);
+            memmove(pending, pending + used, pendingLength - used);
+            pendingLength -= used;
+        }
+        UniqueWindow window = cursor.best;
+        window.offset -= baseByte;
+        return window;
+    }
+};
+
+// Поиск по файлу, читаемому порциями по 1 МБ
+UniqueWindow scanFile(const char* path, bool utf8) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        throw runtime_error(string("не удалось открыть файл ") + path);
+    }
+    UniqueSubstringEngine engine(utf8);
+    vector<char> buffer(1 << 20);
+    size_t n;
+    while ((n = fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+        engine.feed(buffer.data(), n);
+    }
+    bool failed = ferror(file) != 0; // Короткое чтение - конец файла или ошибка
+    fclose(file);
+    if (failed) {
+        throw runtime_error(string("ошибка чтения файла ") + path);
+    }
+    return engine.finish();
+}
+
+// Время выполнения func в секундах
+template <typename Func>
+double measureSeconds(Func func) {
+    auto begin = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+// Кодирование кодовой точки в UTF-8
+void appendUtf8(string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+// Проверка на случайных данных: байтовый режим против исходного алгоритма,
+// режим UTF-8 против перебора по известной последовательности кодовых точек,
+// подача случайными порциями против подачи целиком
+void runDifferentialTest(int cases) {
+    unsigned seed = 2024;
+    int mismatches = 0;
+    const uint32_t alphabet[] = {'a', 'b', 'c', 0xE9, 0x416, 0x44F, 0x20AC, 0x1F600};
+    UniqueSubstringEngine bytes(false), points(true);
+    for (int t = 0; t < cases; ++t) {
+        seed = seed * 1103515245u + 12345u;
+        size_t length = (seed >> 16) % 40;
+        vector<uint32_t> cps;
+        string text;
+        for (size_t i = 0; i < length; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            cps.push_back(alphabet[(seed >> 16) % (t % 2 ? 8 : 3)]);
+            appendUtf8(text, cps.back());
+        }
+
+        int maxLength;
+        string longest;
+        longestUniqueHash(text, maxLength, longest);
+        bytes.reset();
+        for (size_t pos = 0; pos < text.size();) {
+            seed = seed * 1103515245u + 12345u;
+            size_t part = min(text.size() - pos, (size_t)(seed >> 16) % 5 + 1);
+            bytes.feed(text.data() + pos, part);
+            pos += part;
+        }
+        UniqueWindow window = bytes.finish();
+        if (window.bytes != (uint64_t)maxLength || text.substr(window.offset, window.bytes) != longest) {
+            ++mismatches;
+        }
+
+        // Перебор: самое длинное окно из различных кодовых точек (первое из самых длинных)
+        size_t bestLength = 0, bestStart = 0;
+        for (size_t i = 0; i < cps.size(); ++i) {
+            size_t j = i;
+            while (j < cps.size() && find(cps.begin() + i, cps.begin() + j, cps[j]) == cps.begin() + j) {
+                ++j;
+            }
+            if (j - i > bestLength) {
+                bestLength = j - i;
+                bestStart = i;
+            }
+        }
+        string expected;
+        for (size_t i = bestStart; i < bestStart + bestLength; ++i) {
+            appendUtf8(expected, cps[i]);
+        }
+        points.reset();
+        for (size_t pos = 0; pos < text.size();) {
+            seed = seed * 1103515245u + 12345u;
+            size_t part = min(text.size() - pos, (size_t)(seed >> 16) % 3 + 1);
+            points.feed(text.data() + pos, part);
+            pos += part;
+        }
+        window = points.finish();
+        if (window.units != bestLength || text.substr(window.offset, window.bytes) != expected) {
+            ++mismatches;
+        }
+    }
+    cout << "Случайных проверок: " << cases << ", расхождений: " << mismatches << endl;
+}
+
+// Бенчмарк пропускной способности на данных размером megabytes МБ
+void runBenchmark(size_t megabytes) {
+    runDifferentialTest(20000);
+
+    size_t size = megabytes << 20;
+    unsigned seed = 7;
+    string randomBytes(size, 0), text;
+    for (char& c : randomBytes) {
+        seed = seed * 1103515245u + 12345u;
+        c = (char)(seed >> 16);
+    }
+    // Текст вперемешку латиницей и кириллицей
+    text.reserve(size + 4);
+    while (text.size() < size) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t r = seed >> 16;
+        appendUtf8(text, r % 3 == 0 ? 0x430 + r % 32 : 'a' + r % 26);
+    }
+
+    struct Case {
+        const char* name;
+        const string* data;
+        bool utf8;
+    };
+    const Case cases[] = {{"случайные байты, байтовый режим", &randomBytes, false},
+                          {"текст, байтовый режим", &text, false},
+                          {"текст, режим UTF-8", &text, true}};
+    for (const Case& c : cases) {
+        UniqueSubstringEngine engine(c.utf8);
+        UniqueWindow window;
+        double seconds = measureSeconds([&] {
+            for (size_t pos = 0; pos < c.data->size(); pos += 1 << 20) {
+                engine.feed(c.data->data() + pos, min((size_t)1 << 20, c.data->size() - pos));
+            }
+            window = engine.finish();
+        });
+        cout << c.name << ": " << c.data->size() / seconds / 1e9 << " ГБ/с, окно со смещения " << window.offset
+             << ", " << window.units << " символов (" << window.bytes << " байт)" << endl;
+    }
+
+    // Исходный алгоритм на части данных
+    size_t sample = min(size, (size_t)16 << 20);
+    string part = randomBytes.substr(0, sample);
+    int maxLength;
+    string longest;
+    double seconds = measureSeconds([&] { longestUniqueHash(part, maxLength, longest); });
+    cout << "хеш-таблица Hash (" << sample / 1e6 << " МБ случайных байтов): " << sample / seconds / 1e9
+         << " ГБ/с, длина " << maxLength << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runBenchmark(argc > 2 ? strtoull(argv[2], nullptr, 10) : 256); // Режим замера производительности
+        return 0;
+    }
+    // Поиск по файлу: --file <путь> [--utf8]
+    if (argc > 2 && string(argv[1]) == "--file") {
+        try {
+            bool utf8 = argc > 3 && string(argv[3]) == "--utf8";
+            UniqueWindow window = scanFile(argv[2], utf8);
+            cout << "offset=" << window.offset << " bytes=" << window.bytes << " length=" << window.units << endl;
+        } catch (const runtime_error& e) {
+            cerr << "Ошибка: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    string s; // Объявляем строку для хранения пользовательского ввода
+    cout << "Введите строку: ";
+    getline(cin, s); // Читаем строку, включая пробелы
+
+    // Как в исходной программе, символ - байт; с --utf8 символы считаются кодовыми точками,
+    // чтобы кириллица не делилась на байты
+    bool utf8 = argc > 1 && string(argv[1]) == "--utf8";
+    UniqueSubstringEngine engine(utf8);
+    engine.feed(s.data(), s.size());
+    UniqueWindow window = engine.finish();
+
+    // Выводим результат
+    cout << window.units << " (";
+    cout.write(s.data() + window.offset, window.bytes);
+    cout << ")" << endl;
+
+    return 0;
+}
+